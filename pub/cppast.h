@@ -40,10 +40,12 @@
 #include "string-utils.h"
 
 #include <boost/optional.hpp>
+#include <boost/utility/string_view.hpp>
 
 #include <cstdint>
-#include <list>
+#include <cstring>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -51,6 +53,7 @@
 //////////////////////////////////////////////////////////////////////////
 
 struct CppCompound;
+class CppObjFactory;
 
 /**
  * An abstract class that is used as base class of all other classes.
@@ -60,12 +63,7 @@ struct CppObj
   const CppObjType    objType_;
   const CppAccessType accessType_; ///< All objects do not need this.
 
-  CppObj(CppObjType type, CppAccessType accessType)
-    : objType_(type)
-    , accessType_(accessType)
-    , owner_(nullptr)
-  {
-  }
+  CppObj(CppObjType type, CppAccessType accessType);
 
   CppCompound* owner() const
   {
@@ -681,7 +679,7 @@ private:
 
 using CppFwdClsDeclEPtr = CppEasyPtr<CppFwdClsDecl>;
 
-using CppInheritanceList    = std::list<CppInheritInfo>;
+using CppInheritanceList    = std::vector<CppInheritInfo>;
 using CppInheritanceListPtr = std::unique_ptr<CppInheritanceList>;
 using CppObjPtrArray        = std::vector<std::unique_ptr<CppObj>>;
 
@@ -1085,11 +1083,11 @@ using CppFunctionPointerEPtr = CppEasyPtr<CppFunctionPointer>;
 /**
  * Class data member initialization as part of class constructor.
  */
-using CppMemInit = std::pair<std::string, CppExpr*>;
+using CppMemInit = std::pair<std::string, CppExprPtr>;
 /**
  * Entire member initialization list.
  */
-using CppMemInitList = std::list<CppMemInit>;
+using CppMemInitList = std::vector<CppMemInit>;
 
 struct CppConstructor : public CppFuncCtorBase
 {
@@ -1249,18 +1247,29 @@ using CppDocCommentEPtr = CppEasyPtr<CppDocComment>;
 struct CppExpr;
 /**
  * An individual expression.
+ *
+ * Text of an atom (identifier, number, literal, etc.) is stored inside the object itself when it is short enough
+ * and only longer texts need an allocation. CppExprAtom is copied bitwise and the owner is responsible to call
+ * destroy() exactly once.
  */
 struct CppExprAtom
 {
+  static constexpr std::size_t kMaxInlineAtomLen = 16;
+
   union
   {
-    std::string* atom;
-    CppExpr*     expr;
-    CppLambda*   lambda;
-    CppVarType*  varType; //!< For type cast, and sizeof expression.
+    char inlineAtom_[kMaxInlineAtomLen];
+    struct
+    {
+      char*         sz;
+      std::uint32_t len;
+    } heapAtom_;
+    CppExpr*    expr;
+    CppLambda*  lambda;
+    CppVarType* varType; //!< For type cast, and sizeof expression.
   };
 
-  enum
+  enum : std::uint8_t
   {
     kInvalid,
     kAtom,
@@ -1275,18 +1284,16 @@ struct CppExprAtom
   }
 
   CppExprAtom(const char* sz, size_t l)
-    : atom(new std::string(sz, l))
-    , type(kAtom)
+    : type(kAtom)
   {
+    atom(sz, l);
   }
   CppExprAtom(const char* sz)
-    : atom(new std::string(sz))
-    , type(kAtom)
+    : CppExprAtom(sz, std::strlen(sz))
   {
   }
-  CppExprAtom(std::string tok)
-    : atom(new std::string(std::move(tok)))
-    , type(kAtom)
+  CppExprAtom(const std::string& tok)
+    : CppExprAtom(tok.data(), tok.size())
   {
   }
   CppExprAtom(CppExpr* e)
@@ -1305,14 +1312,47 @@ struct CppExprAtom
   {
   }
   CppExprAtom()
-    : atom(nullptr)
+    : expr(nullptr)
     , type(kInvalid)
   {
   }
+
+  /**
+   * @return Text of atom. It is valid only when type is kAtom.
+   */
+  boost::string_view atom() const
+  {
+    if (inlineAtomLen_ == kHeapAtom)
+      return boost::string_view(heapAtom_.sz, heapAtom_.len);
+    return boost::string_view(inlineAtom_, inlineAtomLen_);
+  }
+
   /**
    * It is expected to be called explicitly to destroy an CppExprAtom object.
    */
   void destroy() const;
+
+private:
+  void atom(const char* sz, size_t l)
+  {
+    if (l <= kMaxInlineAtomLen)
+    {
+      std::memcpy(inlineAtom_, sz, l);
+      inlineAtomLen_ = static_cast<std::uint8_t>(l);
+    }
+    else
+    {
+      heapAtom_.sz  = new char[l];
+      heapAtom_.len = static_cast<std::uint32_t>(l);
+      std::memcpy(heapAtom_.sz, sz, l);
+      inlineAtomLen_ = kHeapAtom;
+    }
+  }
+
+private:
+  static constexpr std::uint8_t kHeapAtom = 0xFF;
+
+  std::uint8_t inlineAtomLen_{0}; // Length of inline text, or kHeapAtom when text is stored in heap.
 };
 
 /**
@@ -1419,7 +1459,7 @@ struct CppEnumItem
   }
 };
 
-using CppEnumItemList    = std::list<CppEnumItem*>;
+using CppEnumItemList    = std::vector<std::unique_ptr<CppEnumItem>>;
 using CppEnumItemListPtr = std::unique_ptr<CppEnumItemList>;
 
 struct CppEnum : public CppObj
@@ -1443,6 +1483,22 @@ struct CppEnum : public CppObj
     , underlyingType_(std::move(underlyingType))
   {
   }
+
+  /// @return true if body was kept as a single CppBlob, see CppParser::parseEnumBodyAsBlob().
+  bool isBodyBlob() const;
+  /**
+   * Same as itemList_ except that body that was kept as blob is parsed on first call and the result is cached.
+   * @param objFactory Creates objects of parsed body, it should be factory of the parser that parsed the enum.
+   *                   nullptr means CppObjFactory itself. Only the first call parses and so only its factory is used.
+   * @return nullptr for forward declared enum and also when blob cannot be parsed.
+   * \note Blob is parsed by parser, which is not reentrant. Calls of items() of different enums are serialized but
+   *       items() must not run while any other parse is going on, e.g. CppParser::parseFile() on another thread.
+   */
+  const CppEnumItemList* items(const CppObjFactory* objFactory = nullptr) const;
+
+private:
+  mutable CppObjPtr      parsedBody_; // Enum parsed from text of blob body, whose itemList_ is returned by items().
+  mutable std::once_flag bodyParsed_;
 };
 
 using CppEnumEPtr = CppEasyPtr<CppEnum>;
@@ -1590,6 +1646,10 @@ struct CppTryBlock : public CppObj
   {
     catchBlocks_.emplace_back(catchBlock);
   }
+  const CppCatchBlocks& catchBlocks() const
+  {
+    return catchBlocks_;
+  }
 
 private:
   CppCatchBlocks catchBlocks_;
@@ -1633,7 +1693,8 @@ inline void CppExprAtom::destroy() const
   switch (type)
   {
     case CppExprAtom::kAtom:
-      delete atom;
+      if (inlineAtomLen_ == kHeapAtom)
+        delete[] heapAtom_.sz;
       break;
     case CppExprAtom::kExpr:
       delete expr;
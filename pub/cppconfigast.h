@@ -0,0 +1,99 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "cppast.h"
+
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * \brief AST of one configuration of macros, see CppParser::parseFileForConfigs().
+ * It can be a view of an AST that is shared with other configurations and has all branches of #if parsed. Then members
+ * that are in inactive branches for this configuration are hidden. Directives of #if themselves are never hidden.
+ */
+class CppConfigAst
+{
+public:
+  using HiddenMembers = std::unordered_set<const CppObj*>;
+
+public:
+  CppConfigAst() = default;
+  CppConfigAst(std::shared_ptr<const CppCompound> ast, std::shared_ptr<const HiddenMembers> hiddenMembers = nullptr)
+    : ast_(std::move(ast))
+    , hiddenMembers_(std::move(hiddenMembers))
+  {
+  }
+
+  /// AST that can also have members of other configurations.
+  const std::shared_ptr<const CppCompound>& ast() const
+  {
+    return ast_;
+  }
+  const CppCompound* get() const
+  {
+    return ast_.get();
+  }
+  const CppCompound* operator->() const
+  {
+    return ast_.get();
+  }
+  explicit operator bool() const
+  {
+    return ast_ != nullptr;
+  }
+
+  /// @return false for a member of an inactive branch of #if, and so for everything in it.
+  bool isVisible(const CppObj* member) const
+  {
+    return !hiddenMembers_ || (hiddenMembers_->count(member) == 0);
+  }
+  /// @return members of \a compound, which must be a visible part of AST, as this configuration has them.
+  std::vector<const CppObj*> members(const CppCompound* compound) const
+  {
+    std::vector<const CppObj*> visibleMembers;
+    visibleMembers.reserve(compound->members().size());
+    for (const auto& mem : compound->members())
+    {
+      if (isVisible(mem.get()))
+        visibleMembers.push_back(mem.get());
+    }
+    return visibleMembers;
+  }
+
+  /// Configurations that choose same branches of #if are equal.
+  bool operator==(const CppConfigAst& rhs) const
+  {
+    return (ast_ == rhs.ast_) && (hiddenMembers_ == rhs.hiddenMembers_);
+  }
+  bool operator!=(const CppConfigAst& rhs) const
+  {
+    return !(*this == rhs);
+  }
+
+private:
+  std::shared_ptr<const CppCompound>   ast_;
+  std::shared_ptr<const HiddenMembers> hiddenMembers_; ///< nullptr when AST has only the branches of configuration.
+};
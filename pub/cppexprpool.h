@@ -0,0 +1,126 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "cppast.h"
+
+#include <boost/utility/string_view.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Contiguous and index based storage of all expressions of a function body.
+ *
+ * Every CppExpr is a separate heap object and its children are reached through pointers.
+ * CppExprPool flattens expressions of a body into an array of nodes in which children always precede their parent.
+ * Texts of atoms are kept in a side table so that walking the nodes does not touch any heap object.
+ * Lambdas and types used in expressions remain owned by the body and the pool only refers to them.
+ * The pool refers to the body it is built from and so it must not outlive that body.
+ */
+class CppExprPool
+{
+public:
+  using Index = std::uint32_t;
+
+  static constexpr Index kInvalidIndex = static_cast<Index>(-1);
+
+  struct Atom
+  {
+    /// Has same meaning as CppExprAtom::type.
+    std::uint8_t type;
+    /// Index in atom text table, node array or object table depending upon type.
+    Index idx;
+  };
+
+  struct Node
+  {
+    CppOperator oper;
+    short       flags;
+    Atom        atoms[3];
+  };
+
+public:
+  CppExprPool() = default;
+  /**
+   * Builds pool of all expressions that appear as statement, condition, or initializer within the given body.
+   */
+  explicit CppExprPool(const CppCompound* body);
+
+  /**
+   * Flattens an expression into the pool.
+   * @return index of the node for given expression.
+   */
+  Index add(const CppExpr* expr);
+
+  const std::vector<Node>& nodes() const
+  {
+    return nodes_;
+  }
+  const Node& node(Index idx) const
+  {
+    return nodes_[idx];
+  }
+  /// Indices of top level expressions in the order they appear in body.
+  const std::vector<Index>& roots() const
+  {
+    return roots_;
+  }
+
+  boost::string_view atom(Index idx) const
+  {
+    const auto& span = atomSpans_[idx];
+    return boost::string_view(atomText_.data() + span.first, span.second);
+  }
+  const CppLambda* lambda(Index idx) const
+  {
+    return static_cast<const CppLambda*>(objs_[idx]);
+  }
+  const CppVarType* varType(Index idx) const
+  {
+    return static_cast<const CppVarType*>(objs_[idx]);
+  }
+
+  /**
+   * Materializes the node as CppExpr for code that works only with CppExpr.
+   * @return the expression from which the node was created.
+   */
+  const CppExpr* expr(Index idx) const
+  {
+    return exprs_[idx];
+  }
+
+private:
+  Atom addAtom(const CppExprAtom& exprAtom);
+  void addExprs(const CppObj* obj);
+
+private:
+  std::vector<Node>                            nodes_;
+  std::vector<Index>                           roots_;
+  std::string                                  atomText_;
+  std::vector<std::pair<Index, std::uint32_t>> atomSpans_; // Offset and length in atomText_.
+  std::vector<const CppObj*>                   objs_;
+  std::vector<const CppExpr*>                  exprs_;
+};
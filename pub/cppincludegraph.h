@@ -0,0 +1,114 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "cppast.h"
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using CppFileAstArray = std::vector<const CppCompound*>;
+using CppIncludeArray = std::vector<const CppInclude*>;
+
+/**
+ * \brief Graph of files of a program connected by #include directives.
+ *
+ * An #include "file" is resolved relative to directory of the including file and then against include roots.
+ * An #include <file> is resolved only against include roots.
+ * Only includes that resolve to files of the program become edges of the graph, others are reported as unresolved.
+ * \note Graph refers to ASTs of files and so it must not outlive them.
+ */
+class CppIncludeGraph
+{
+public:
+  CppIncludeGraph() = default;
+  CppIncludeGraph(const std::vector<CppCompoundPtr>& fileAsts, const std::vector<std::string>& includeRoots);
+
+public:
+  /// @return Files directly included by \a fileAst.
+  const CppFileAstArray& includes(const CppCompound* fileAst) const;
+  /// @return Files that directly include \a fileAst.
+  const CppFileAstArray& includedBy(const CppCompound* fileAst) const;
+  /// @return #include directives of \a fileAst that could not be resolved to any file of the program.
+  const CppIncludeArray& unresolvedIncludes(const CppCompound* fileAst) const;
+
+  /**
+   * @return All files ordered such that a file comes after the files it includes.
+   * \note Cyclic includes are broken at the include that closes the cycle, in the order files were added.
+   */
+  const CppFileAstArray& topologicalOrder() const
+  {
+    return topologicalOrder_;
+  }
+
+  /**
+   * @return All files that directly or indirectly include \a fileAst, in topological order.
+   * These are the files that need to be reprocessed when \a fileAst changes.
+   */
+  CppFileAstArray dependents(const CppCompound* fileAst) const;
+
+  /**
+   * Adds files to graph.
+   * Only includes of new files and includes of other files that could not be resolved so far are resolved.
+   */
+  void addFiles(const CppFileAstArray& fileAsts);
+  /**
+   * Removes a file from graph, includes of other files that resolved to it are resolved again.
+   * \note \a fileAst is only compared with files of graph and so it can be called even after the AST is gone.
+   */
+  void removeFile(const CppCompound* fileAst);
+
+private:
+  struct FileNode
+  {
+    explicit FileNode(const CppCompound* ast)
+      : fileAst(ast)
+    {
+    }
+
+    const CppCompound* fileAst;
+    CppFileAstArray    includes;
+    CppFileAstArray    includedBy;
+    CppIncludeArray    unresolvedIncludes;
+    /// Each include that got resolved and file it resolved to, needed to resolve it again when that file goes away.
+    std::vector<std::pair<const CppInclude*, const CppCompound*>> resolvedIncludes;
+    size_t                                                        topologicalIndex{0};
+  };
+
+  const FileNode* fileNode(const CppCompound* fileAst) const;
+  const FileNode* resolveInclude(const FileNode& file, const std::string& includeName) const;
+  void            addFileNode(const CppCompound* fileAst);
+  void            addInclude(size_t fileIdx, const CppInclude* include);
+  void            addIncludes(size_t fileIdx);
+  void            sortTopologically();
+
+private:
+  std::vector<std::string>                       includeRoots_;
+  std::vector<FileNode>                          files_;
+  std::unordered_map<const CppCompound*, size_t> fileAstToIdx_;
+  std::unordered_map<std::string, size_t>        pathToIdx_;
+  CppFileAstArray                                topologicalOrder_;
+};
@@ -23,8 +23,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <ostream>
+#include <string>
 
 /**
  * \brief Helper class to manage indentation.
@@ -83,21 +85,38 @@ public:
     static const char* indent[] = {"\t", " ", "  ", "   ", "    "};
     return indent[type_];
   }
-  std::string toString() const
+  /// @return Number of characters in indentation.
+  size_t length() const
   {
-    std::string ret;
-    for (std::uint16_t i = 0; i < initialLevel_ + indentLevel_; ++i)
+    const size_t unitLength = (type_ == kTab) ? 1 : type_;
+    return unitLength * (initialLevel_ + indentLevel_);
+  }
+  /**
+   * Calls \a writeChunk with pieces of a precomputed string that together make the indentation.
+   * Usually there is just one piece and so indentation is written in one go.
+   */
+  template <typename WriteChunk>
+  void writeChunks(WriteChunk&& writeChunk) const
+  {
+    static const std::string tabs(64, '\t');
+    static const std::string spaces(256, ' ');
+    const auto&              indents = (type_ == kTab) ? tabs : spaces;
+    for (auto len = length(); len != 0;)
     {
-      ret += indentStr();
+      const auto chunkLength = std::min(len, indents.size());
+      writeChunk(indents.data(), chunkLength);
+      len -= chunkLength;
     }
-    
+  }
+  std::string toString() const
+  {
+    std::string ret;
+    ret.reserve(length());
+    writeChunks([&ret](const char* chunk, size_t len) { ret.append(chunk, len); });
     return ret;
   }
   void emit(std::ostream& stm) const
   {
-    for (std::uint16_t i = 0; i < initialLevel_ + indentLevel_; ++i)
-    {
-      stm << indentStr();
-    }
+    writeChunks([&stm](const char* chunk, size_t len) { stm.write(chunk, len); });
   }
 };
@@ -0,0 +1,124 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "cppast.h"
+#include "cppparserstats.h"
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <string>
+
+class CppProgram;
+
+/**
+ * \brief Number and size of objects of AST.
+ */
+struct CppMemoryUsage
+{
+  std::size_t numObjs  = 0;
+  std::size_t numBytes = 0; ///< Size of objects and of heap data owned by them, excluding overhead of allocator.
+
+  CppMemoryUsage& operator+=(const CppMemoryUsage& rhs)
+  {
+    numObjs += rhs.numObjs;
+    numBytes += rhs.numBytes;
+    return *this;
+  }
+};
+
+using CppMemoryUsageByType = std::array<CppMemoryUsage, kNumCppObjTypes>;
+using CppMemoryUsageByName = std::map<std::string, CppMemoryUsage>;
+
+/**
+ * \brief Report of memory used by ASTs, broken down by type of objects, by files and by top level namespaces.
+ *
+ * Every object is accounted to its own CppObjType together with the heap data it owns that is not a CppObj itself,
+ * e.g. strings, member vectors, text of expression atoms, template parameter lists and enum items.
+ * Owned objects that are CppObj, like the CppVarType of a CppVar, are accounted to their own type.
+ */
+class CppMemoryReport
+{
+public:
+  CppMemoryReport() = default;
+  explicit CppMemoryReport(const CppCompound* fileAst);
+  explicit CppMemoryReport(const CppProgram& program);
+
+public:
+  /**
+   * Adds objects of an AST to this report.
+   * \note Name of \a fileAst is used as key of file totals, ASTs with same name are accounted as one file.
+   */
+  void addFile(const CppCompound* fileAst);
+
+  const CppMemoryUsageByType& byType() const
+  {
+    return byType_;
+  }
+  const CppMemoryUsage& ofType(CppObjType objType) const
+  {
+    return byType_[static_cast<std::size_t>(objType)];
+  }
+  /// @return Totals of files keyed by name of file.
+  const CppMemoryUsageByName& byFile() const
+  {
+    return byFile_;
+  }
+  /**
+   * @return Totals of top level namespaces keyed by their names.
+   * Objects outside of any namespace, including the file compounds themselves, and objects of anonymous namespaces
+   * are accounted under empty name. Namespaces opened many times and in many files are accounted as one.
+   */
+  const CppMemoryUsageByName& byNamespace() const
+  {
+    return byNamespace_;
+  }
+
+  CppMemoryUsage total() const;
+
+private:
+  /// Totals, other than type total, to which an object is accounted.
+  struct Accounts
+  {
+    CppMemoryUsage* file;
+    CppMemoryUsage* topNamespace;
+    bool            atFileScope; ///< true when members of object are directly at file scope.
+  };
+
+  void        add(const CppObj* obj, const Accounts& accounts);
+  void        record(CppObjType objType, std::size_t numBytes, const Accounts& accounts);
+  std::size_t compoundBytes(const CppCompound* compound, const Accounts& accounts);
+  std::size_t varDeclBytes(const CppVarDecl& varDecl, const Accounts& accounts);
+  std::size_t exprAtomBytes(const CppExprAtom& exprAtom, const Accounts& accounts);
+  std::size_t templateParamListBytes(const CppTemplateParamList* templParamList, const Accounts& accounts);
+  std::size_t paramsBytes(const CppParamVector* params, const Accounts& accounts);
+  std::size_t funcLikeBytes(const CppFuncLikeBase* func, const Accounts& accounts);
+  std::size_t functionBaseBytes(const CppFunctionBase* func, const Accounts& accounts);
+
+private:
+  CppMemoryUsageByType byType_{};
+  CppMemoryUsageByName byFile_;
+  CppMemoryUsageByName byNamespace_;
+};
@@ -0,0 +1,255 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "cppindent.h"
+
+#include <boost/utility/string_view.hpp>
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Growable in-memory buffer to which generated code is emitted.
+ * It is a std::streambuf so that CppWriter can emit into it through CppOutputStream.
+ * Characters are appended directly into the buffer and so no stream machinery is involved in putting them.
+ * The whole content can then be written to a std::ostream or to a file in one go.
+ */
+class CppOutputBuffer : public std::streambuf
+{
+public:
+  explicit CppOutputBuffer(size_t initialCapacity = 64 * 1024);
+
+  CppOutputBuffer(const CppOutputBuffer&) = delete;
+  CppOutputBuffer& operator=(const CppOutputBuffer&) = delete;
+
+public:
+  void append(const char* str, size_t len);
+  void append(boost::string_view str);
+  void append(char c);
+  void append(const CppIndent& indentation);
+
+  const char*        data() const;
+  size_t             size() const;
+  boost::string_view str() const;
+  void               clear();
+
+  void writeTo(std::ostream& stm) const;
+  /**
+   * Writes content of buffer to file, replacing the file if it exists.
+   * @return false if the file could not be written.
+   */
+  bool writeToFile(const std::string& filePath) const;
+
+protected:
+  int_type        overflow(int_type c) override;
+  std::streamsize xsputn(const char* str, std::streamsize len) override;
+
+private:
+  void reserve(size_t len);
+
+private:
+  std::vector<char> buffer_;
+};
+
+/**
+ * \brief std::ostream that emits into a CppOutputBuffer.
+ */
+class CppOutputStream : public std::ostream
+{
+public:
+  explicit CppOutputStream(size_t initialCapacity = 64 * 1024);
+
+  CppOutputBuffer&       buffer();
+  const CppOutputBuffer& buffer() const;
+
+  /**
+   * @return Buffer of \a stm if it is a CppOutputStream that still writes into its own buffer, nullptr otherwise.
+   * It costs an array lookup, so it can be called for every small piece of emitted text.
+   */
+  static CppOutputBuffer* bufferOf(std::ostream& stm);
+
+private:
+  /// Index of storage in stream whose pword() points to buffer_ of CppOutputStream, it is null for other streams.
+  static const int kBufferIdx;
+
+  CppOutputBuffer buffer_;
+};
+
+/**
+ * \brief Inserts into a std::ostream but appends strings, characters, and indentation directly to CppOutputBuffer when
+ * the stream is a CppOutputStream. It saves sentry and locale handling of std::ostream, which dominate cost of inserting
+ * short pieces of text. Everything else is inserted into the stream as usual.
+ */
+class CppOutputInserter
+{
+public:
+  explicit CppOutputInserter(std::ostream& stm);
+
+  CppOutputInserter& operator<<(char c);
+  CppOutputInserter& operator<<(const char* str);
+  CppOutputInserter& operator<<(const std::string& str);
+  CppOutputInserter& operator<<(boost::string_view str);
+  CppOutputInserter& operator<<(const CppIndent& indentation);
+
+  template <typename T>
+  CppOutputInserter& operator<<(const T& value)
+  {
+    stm_ << value;
+    return *this;
+  }
+
+private:
+  std::ostream&    stm_;
+  CppOutputBuffer* buffer_;
+};
+
+inline void CppOutputBuffer::append(const char* str, size_t len)
+{
+  if (static_cast<size_t>(epptr() - pptr()) < len)
+    reserve(len);
+  std::char_traits<char>::copy(pptr(), str, len);
+  pbump(static_cast<int>(len));
+}
+
+inline void CppOutputBuffer::append(boost::string_view str)
+{
+  append(str.data(), str.size());
+}
+
+inline void CppOutputBuffer::append(char c)
+{
+  if (pptr() == epptr())
+    reserve(1);
+  *pptr() = c;
+  pbump(1);
+}
+
+inline void CppOutputBuffer::append(const CppIndent& indentation)
+{
+  indentation.writeChunks([this](const char* chunk, size_t len) { append(chunk, len); });
+}
+
+inline const char* CppOutputBuffer::data() const
+{
+  return pbase();
+}
+
+inline size_t CppOutputBuffer::size() const
+{
+  return pptr() - pbase();
+}
+
+inline boost::string_view CppOutputBuffer::str() const
+{
+  return boost::string_view(data(), size());
+}
+
+inline void CppOutputBuffer::clear()
+{
+  setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+inline CppOutputStream::CppOutputStream(size_t initialCapacity)
+  : std::ostream(nullptr)
+  , buffer_(initialCapacity)
+{
+  rdbuf(&buffer_);
+  pword(kBufferIdx) = &buffer_;
+}
+
+inline CppOutputBuffer& CppOutputStream::buffer()
+{
+  return buffer_;
+}
+
+inline const CppOutputBuffer& CppOutputStream::buffer() const
+{
+  return buffer_;
+}
+
+inline CppOutputBuffer* CppOutputStream::bufferOf(std::ostream& stm)
+{
+  auto* buffer = static_cast<CppOutputBuffer*>(stm.pword(kBufferIdx));
+  return (buffer == stm.rdbuf()) ? buffer : nullptr;
+}
+
+inline CppOutputInserter::CppOutputInserter(std::ostream& stm)
+  : stm_(stm)
+  , buffer_(CppOutputStream::bufferOf(stm))
+{
+}
+
+inline CppOutputInserter& CppOutputInserter::operator<<(char c)
+{
+  if (buffer_)
+    buffer_->append(c);
+  else
+    stm_ << c;
+  return *this;
+}
+
+inline CppOutputInserter& CppOutputInserter::operator<<(const char* str)
+{
+  if (buffer_)
+    buffer_->append(str, std::char_traits<char>::length(str));
+  else
+    stm_ << str;
+  return *this;
+}
+
+inline CppOutputInserter& CppOutputInserter::operator<<(const std::string& str)
+{
+  if (buffer_)
+    buffer_->append(str.data(), str.size());
+  else
+    stm_ << str;
+  return *this;
+}
+
+inline CppOutputInserter& CppOutputInserter::operator<<(boost::string_view str)
+{
+  if (buffer_)
+    buffer_->append(str);
+  else
+    stm_ << str;
+  return *this;
+}
+
+inline CppOutputInserter& CppOutputInserter::operator<<(const CppIndent& indentation)
+{
+  if (buffer_)
+    buffer_->append(indentation);
+  else
+    indentation.emit(stm_);
+  return *this;
+}
+
+inline std::ostream& operator<<(std::ostream& stm, const CppOutputBuffer& buffer)
+{
+  buffer.writeTo(stm);
+  return stm;
+}
@@ -0,0 +1,79 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+
+/// Outcome of a parsing done by CppParser.
+enum class CppParseStatus
+{
+  kSuccess,
+  kParseError, ///< Input could not be read or parsed.
+  kCancelled,  ///< CppCancellationToken of parser got cancelled.
+  kTimeBudgetExceeded,
+  kAllocationBudgetExceeded
+};
+
+inline const char* toString(CppParseStatus status)
+{
+  switch (status)
+  {
+    case CppParseStatus::kSuccess:
+      return "success";
+    case CppParseStatus::kParseError:
+      return "parse error";
+    case CppParseStatus::kCancelled:
+      return "cancelled";
+    case CppParseStatus::kTimeBudgetExceeded:
+      return "time budget exceeded";
+    case CppParseStatus::kAllocationBudgetExceeded:
+      return "allocation budget exceeded";
+  }
+  return "";
+}
+
+/**
+ * \brief Lets parsing be cancelled cooperatively from another thread.
+ * Parser checks the token before each token it lexes and before each trial parse.
+ */
+class CppCancellationToken
+{
+public:
+  void cancel()
+  {
+    cancelled_.store(true, std::memory_order_relaxed);
+  }
+  bool isCancelled() const
+  {
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+  /// Makes token usable again for another parsing.
+  void reset()
+  {
+    cancelled_.store(false, std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<bool> cancelled_{false};
+};
@@ -23,7 +23,19 @@
 
 #pragma once
 
+#include "cppconfigast.h"
 #include "cppobjfactory.h"
+#include "cppparsecontrol.h"
+#include "cppparserstats.h"
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class CppTracer;
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -33,9 +45,33 @@ public:
   CppParser(CppObjFactoryPtr objFactory = nullptr);
   CppParser(CppParser&& rhs)
     : objFactory_(std::move(rhs.objFactory_))
+    , collectStats_(rhs.collectStats_)
+    , allocationCounter_(rhs.allocationCounter_)
+    , stats_(rhs.stats_)
+    , lastParseStats_(rhs.lastParseStats_)
+    , tracer_(rhs.tracer_)
+    , cancellationToken_(rhs.cancellationToken_)
+    , timeBudget_(rhs.timeBudget_)
+    , allocationBudget_(rhs.allocationBudget_)
+    , lastParseStatus_(rhs.lastParseStatus_)
   {
   }
 
+  /// Function that returns number of allocations done so far, e.g. by a replacement of global operator new.
+  using AllocationCounter = std::size_t (*)();
+  /// Definitions of macros of one configuration, e.g. of one platform, keyed by name of macro.
+  using MacroDefinitions = std::map<std::string, std::string>;
+  /// Receiver of debug logs of lexer and parser, one message at a time.
+  using LogSink = std::function<void(const char* msg)>;
+
+  enum DebugLog : unsigned
+  {
+    kNoDebugLog = 0x000,
+    kParseLog   = 0x001,
+    kLexLog     = 0x002,
+    kBtyaccLog  = 0x004
+  };
+
 public:
   void addKnownMacro(std::string knownMacro);
   void addKnownMacros(const std::vector<std::string>& knownMacros);
@@ -48,12 +84,204 @@ public:
 
   bool addRenamedKeyword(const std::string& keyword, std::string renamedKeyword);
 
-  void parseEnumBodyAsBlob();
+  /// Makes lexer keep body of every enum as one CppBlob, see CppEnum::items(), false makes it parse bodies again.
+  void parseEnumBodyAsBlob(bool enable = true);
+  /**
+   * Makes lexer skip body of every namespace whose name matches \a pattern, by matching braces only.
+   * Pattern can use '*' for any sequence of characters and '?' for any one character, e.g. "detail" or "*_impl".
+   * Namespace still appears in AST, with an empty CppBlob as its only member, so that its name remains known.
+   * Braces in preprocessor directives are not counted, and of the branches of #if, #ifdef, and alike only the first
+   * one is counted. So, a body whose braces match only in some other branch is not skipped correctly.
+   */
+  void addSkippedNamespace(std::string pattern);
+  /// Same as addSkippedNamespace() but for bodies of class, struct, and union definitions.
+  void addSkippedClass(std::string pattern);
+  /// Forgets all patterns added using addSkippedNamespace().
+  void clearSkippedNamespaces();
+  /// Forgets all patterns added using addSkippedClass().
+  void clearSkippedClasses();
+
+  /// Declares \a macro as defined, with \a value as its definition, for evaluation of conditions of #if.
+  void defineMacro(std::string macro, std::string value = "1");
+  /// Declares \a macro as not defined for evaluation of conditions of #if.
+  void undefineMacro(std::string macro);
+  /// Forgets every macro declared using defineMacro() and undefineMacro().
+  void clearMacros();
+  /**
+   * Makes lexer skip branches of #if, #ifdef, #ifndef, #elif, and #else that are inactive for macros declared using
+   * defineMacro() and undefineMacro(). Nothing is assumed about other macros and so a chain of branches is parsed as
+   * usual from the first condition that cannot be evaluated. Directives themselves are always kept as CppHashIf.
+   * @param skip false makes lexer parse every branch again, as it does by default.
+   * @param keepAsBlob Keeps text of each skipped branch as CppBlob, which fails parsing where a statement cannot be.
+   */
+  void skipInactivePreproBranches(bool skip = true, bool keepAsBlob = false);
 
 public:
+  /// @return nullptr when parsing fails and lastParseStatus() tells why.
   CppCompoundPtr parseFile(const std::string& filename);
   CppCompoundPtr parseStream(char* stm, size_t stmSize);
+  /// \a streamName is used only to identify the stream in trace events.
+  CppCompoundPtr parseStream(char* stm, size_t stmSize, const std::string& streamName);
+  CppParseStatus lastParseStatus() const;
+  /**
+   * Parses \a filename for each of \a configs with inactive branches of #if skipped as skipInactivePreproBranches() does.
+   * A macro that any of \a configs defines is taken as not defined by those that do not define it.
+   * File is parsed once with all branches and every configuration gets a view of that AST which hides its inactive
+   * branches. When that cannot give same AST as skipping does, e.g. if branches of #if open a block differently, file is
+   * lexed for each configuration to know which branches it takes and it is parsed once per distinct choice of branches.
+   * Either way, configurations that choose same branches get equal CppConfigAst.
+   * @return AST of each configuration in same order as \a configs, null for those that fail to parse.
+   */
+  std::vector<CppConfigAst> parseFileForConfigs(const std::string&                   filename,
+                                                const std::vector<MacroDefinitions>& configs);
+
+public:
+  /**
+   * Sets token whose cancellation stops parsing, nullptr means parsing cannot be cancelled.
+   * \note Token is not owned by parser and it must outlive parsing done with it.
+   */
+  void                        cancellationToken(const CppCancellationToken* token);
+  const CppCancellationToken* cancellationToken() const;
+  /// Sets limit of wall clock time of parsing of one file or stream, zero means no limit.
+  void                                timeBudget(std::chrono::steady_clock::duration budget);
+  std::chrono::steady_clock::duration timeBudget() const;
+  /**
+   * Sets limit of number of allocations done while parsing one file or stream, zero means no limit.
+   * \note Allocations are counted using counter set by setAllocationCounter() and limit has no effect without one.
+   */
+  void        allocationBudget(std::size_t maxAllocations);
+  std::size_t allocationBudget() const;
+
+public:
+  /**
+   * Enables or disables collection of statistics of parsing, it is disabled by default.
+   * \note When disabled, the cost of collection is a check of a null pointer per token, reduction and AST object.
+   */
+  void collectStats(bool enable = true);
+  bool isCollectingStats() const;
+  /**
+   * Sets counter that is used for counting allocations done while parsing.
+   * Library cannot count allocations on its own because that needs replacement of global operator new.
+   */
+  void setAllocationCounter(AllocationCounter allocationCounter);
+  /// @return Statistics accumulated over all parsing done while collection was enabled.
+  const CppParserStats& stats() const;
+  /// @return Statistics of the last parsing done while collection was enabled.
+  const CppParserStats& lastParseStats() const;
+  void                  resetStats();
+
+public:
+  /**
+   * Enables debug logs of lexer and parser, \a logFlags is an ORed combination of DebugLog values.
+   * If it is never called then flags are read from environment variable ZZDEBUG when parsing is done first time.
+   * \note Debug logs exist only if library is built with CPPPARSER_DEBUG_LOG, which is the default for debug builds.
+   * Otherwise lexer and parser do not pay for them at all and this method does nothing.
+   */
+  void debugLog(unsigned logFlags);
+  /**
+   * Sets sink that receives debug logs, nullptr restores the default sink that writes to stdout.
+   * \note Sink is called with a lock held and so it needs no synchronization of its own.
+   */
+  void logSink(LogSink sink);
+
+public:
+  /**
+   * Sets tracer that records reading and parsing of files, slow trials, and slow lexing of tokens.
+   * Tracing is disabled by default and nullptr disables it again.
+   * \note Tracer is not owned by parser and it must outlive parsing done with it.
+   */
+  void       tracer(CppTracer* tracer);
+  CppTracer* tracer() const;
+
+private:
+  CppObjFactoryPtr  objFactory_;
+  bool              collectStats_      = false;
+  AllocationCounter allocationCounter_ = nullptr;
+  CppParserStats    stats_;
+  CppParserStats    lastParseStats_;
+  CppTracer*        tracer_ = nullptr;
+
+  const CppCancellationToken*         cancellationToken_ = nullptr;
+  std::chrono::steady_clock::duration timeBudget_        = std::chrono::steady_clock::duration::zero();
+  std::size_t                         allocationBudget_  = 0;
+  CppParseStatus                      lastParseStatus_   = CppParseStatus::kSuccess;
 
 private:
-  CppObjFactoryPtr objFactory_;
+  CppCompoundPtr parseStreamCollectingStats(char* stm, size_t stmSize);
 };
+
+inline void CppParser::collectStats(bool enable)
+{
+  collectStats_ = enable;
+}
+
+inline bool CppParser::isCollectingStats() const
+{
+  return collectStats_;
+}
+
+inline void CppParser::setAllocationCounter(AllocationCounter allocationCounter)
+{
+  allocationCounter_ = allocationCounter;
+}
+
+inline const CppParserStats& CppParser::stats() const
+{
+  return stats_;
+}
+
+inline const CppParserStats& CppParser::lastParseStats() const
+{
+  return lastParseStats_;
+}
+
+inline void CppParser::resetStats()
+{
+  stats_          = CppParserStats();
+  lastParseStats_ = CppParserStats();
+}
+
+inline void CppParser::tracer(CppTracer* tracer)
+{
+  tracer_ = tracer;
+}
+
+inline CppTracer* CppParser::tracer() const
+{
+  return tracer_;
+}
+
+inline CppParseStatus CppParser::lastParseStatus() const
+{
+  return lastParseStatus_;
+}
+
+inline void CppParser::cancellationToken(const CppCancellationToken* token)
+{
+  cancellationToken_ = token;
+}
+
+inline const CppCancellationToken* CppParser::cancellationToken() const
+{
+  return cancellationToken_;
+}
+
+inline void CppParser::timeBudget(std::chrono::steady_clock::duration budget)
+{
+  timeBudget_ = budget;
+}
+
+inline std::chrono::steady_clock::duration CppParser::timeBudget() const
+{
+  return timeBudget_;
+}
+
+inline void CppParser::allocationBudget(std::size_t maxAllocations)
+{
+  allocationBudget_ = maxAllocations;
+}
+
+inline std::size_t CppParser::allocationBudget() const
+{
+  return allocationBudget_;
+}
@@ -0,0 +1,78 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "cppconst.h"
+
+#include <array>
+#include <cstddef>
+
+/// Number of values of CppObjType.
+constexpr std::size_t kNumCppObjTypes = static_cast<std::size_t>(CppObjType::kCppControlStatementEnds) + 1;
+
+/**
+ * \brief Statistics of parsing of one or more files.
+ * \note Objects and reductions of trial parses that later got discarded are counted too.
+ */
+struct CppParserStats
+{
+  std::size_t numParses      = 0; ///< Number of files or streams parsed.
+  std::size_t numBytes       = 0;
+  std::size_t numTokens      = 0;
+  std::size_t numReductions  = 0; ///< Number of grammar rules reduced.
+  std::size_t numTrials      = 0; ///< Number of trial parses done to resolve conflicts of grammar.
+  std::size_t numAllocations = 0; ///< Counted only when CppParser has an allocation counter.
+  double      lexSeconds     = 0;
+  double      parseSeconds   = 0; ///< Excludes time spent in lexing.
+
+  std::array<std::size_t, kNumCppObjTypes> numObjs{}; ///< Number of AST objects created, indexed by CppObjType.
+
+  std::size_t numObjsOfType(CppObjType objType) const
+  {
+    return numObjs[static_cast<std::size_t>(objType)];
+  }
+
+  std::size_t totalObjs() const
+  {
+    std::size_t total = 0;
+    for (auto n : numObjs)
+      total += n;
+    return total;
+  }
+
+  CppParserStats& operator+=(const CppParserStats& rhs)
+  {
+    numParses += rhs.numParses;
+    numBytes += rhs.numBytes;
+    numTokens += rhs.numTokens;
+    numReductions += rhs.numReductions;
+    numTrials += rhs.numTrials;
+    numAllocations += rhs.numAllocations;
+    lexSeconds += rhs.lexSeconds;
+    parseSeconds += rhs.parseSeconds;
+    for (std::size_t i = 0; i < numObjs.size(); ++i)
+      numObjs[i] += rhs.numObjs[i];
+    return *this;
+  }
+};
@@ -24,12 +24,25 @@
 #pragma once
 
 #include "cppast.h"
+#include "cppincludegraph.h"
 #include "cppparser.h"
+#include "cppsymbolindex.h"
 #include "cpptypetree.h"
 
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include <array>
+#include <cstdint>
+#include <ctime>
+#include <deque>
 #include <functional>
-#include <map>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -72,8 +85,11 @@ public:
    * \note Name can contain scope resolution operator(::).
    * \remarks The search moves upward. E.g. if \a beginFrom does not contain the type whose name is \a name then
    * it is searched in parent node and keeps moving upward till a match is found or type-hierarchy ends without a match.
+   * \note Results, including failed ones, are cached and so repeated search of same name from same node is cheap.
+   * Cache keeps at most kMaxTypeLookups results and it is emptied when it gets full.
+   * It is safe to call this method concurrently from multiple threads.
    */
-  const CppTypeTreeNode* findTypeNode(const std::string& name, const CppTypeTreeNode* beginFrom) const;
+  const CppTypeTreeNode* findTypeNode(boost::string_view name, const CppTypeTreeNode* beginFrom) const;
   /**
    * @return CppTypeTreeNode for CppObj.
    * \note Return value may be nullptr if CppObj does not represent a valid type.
@@ -83,6 +99,32 @@ public:
    * @return An array of CppCompound each element of which represents AST of a C++ file.
    */
   const CppCompoundArray& getFileAsts() const;
+  /**
+   * @return Index of all symbols of the program.
+   * \note Index is built on first call and then kept up to date as files are added, updated, or removed.
+   */
+  const CppSymbolIndex& symbolIndex() const;
+  /**
+   * @return Graph of includes among files of the program.
+   * \note Graph is built on first call and then kept up to date as files are added, updated, or removed.
+   * It is built again only after include roots are modified.
+   */
+  const CppIncludeGraph& includeGraph() const;
+
+  /**
+   * Sets folders against which #include directives are resolved, in the order of search.
+   */
+  void                            includeRoots(std::vector<std::string> roots);
+  const std::vector<std::string>& includeRoots() const;
+
+  /**
+   * @return Statistics of parsing of all files of the program.
+   * \note Statistics are available only if the parser given to the program collects them,
+   * see CppParser::collectStats().
+   */
+  CppParserStats parseStats() const;
+  /// @return Statistics of parsing of a file of the program, nullptr if not available.
+  const CppParserStats* parseStats(const CppCompound* fileAst) const;
 
 public:
   /**
@@ -90,19 +132,143 @@ public:
    * \warning It is a no-op if \a cppAst is not of CppCompoundType::kCppFile type.
    */
   void addCppAst(CppCompoundPtr cppAst);
+  /**
+   * Adds ASTs of many files to this program.
+   * Type-tree of each file is built independently on worker threads and then they are merged into the type-tree of
+   * program in the order of files. So, the result is same as calling addCppAst() for each file.
+   * @param numThreads Number of threads to use, 0 means number of hardware threads.
+   */
+  void addCppAsts(CppCompoundArray cppAsts, unsigned numThreads = 0);
   void addCompound(const CppCompound* compound, const CppCompound* parent);
   void addCompound(const CppCompound* compound, CppTypeTreeNode* parentTypeNode);
 
+  /**
+   * Re-parses files that have changed since they were parsed and removes files that do not exist anymore.
+   * A file is re-parsed only when both its modification time and hash of its content have changed.
+   * Only types of re-parsed files are removed from and added back to the type-tree, rest of it is left untouched.
+   * \note Only files parsed by this program are checked, ASTs added using addCppAst() are not.
+   * @return Number of files that got re-parsed or removed.
+   */
+  size_t refresh();
+  /**
+   * Re-parses a file of the program if its content has changed, or parses and adds the file if it is not part of the
+   * program yet. File is identified by the path that was used to parse it.
+   * \note If new content of file cannot be parsed then its previous AST is kept.
+   * @return true if the program got modified.
+   */
+  bool updateFile(const std::string& file);
+  /**
+   * Removes a file and all types it contributed to the type-tree.
+   * @return false if \a file is not part of the program.
+   */
+  bool removeFile(const std::string& file);
+
 private:
-  void loadType(const CppCompound* cppCompound, CppTypeTreeNode* typeNode);
+  using CppObjToTypeNodeMap      = std::unordered_map<const CppObj*, CppTypeTreeNode*>;
+  /// Objects of each type node and the order in which they got loaded.
+  using CppTypeNodeObjsMap = std::unordered_map<const CppTypeTreeNode*, std::unordered_map<const CppObj*, size_t>>;
+  using CppTypeNodeRelocationMap = std::unordered_map<const CppTypeTreeNode*, CppTypeTreeNode*>;
+
+  /// Number of shards of maps that are filled when types are added, each shard is filled by a single thread.
+  static constexpr size_t kNumShards = 16;
+  /// Number of results of findTypeNode() that are cached at most.
+  static constexpr size_t kMaxTypeLookups = 1 << 16;
+
+  /**
+   * Storage that is filled while types are loaded and later becomes part of the program.
+   * Loading of types touches nothing else and so types of different files can be loaded concurrently.
+   */
+  struct TypeTreeStorage
+  {
+    /// Type node of each loaded object, in the order of loading.
+    std::vector<std::pair<const CppObj*, CppTypeTreeNode*>> objToTypeNode;
+    /// Nodes that got a new address when the type-tree they belong to got merged into that of program.
+    CppTypeNodeRelocationMap relocatedNodes;
+  };
+
+  /// Type-tree of a single file that is built independent of type-tree of program.
+  struct FileTypeTree
+  {
+    CppTypeTreeNode root;
+    TypeTreeStorage storage;
+  };
+
+  /// State of a file on disk when it was parsed, used to know if the file needs to be parsed again.
+  struct FileState
+  {
+    std::time_t modifiedTime;
+    std::size_t contentHash;
+  };
+
+  static void             loadType(const CppCompound* cppCompound, CppTypeTreeNode* typeNode, TypeTreeStorage& storage);
+  static void             loadCompound(const CppCompound* compound,
+                                       CppTypeTreeNode*   parentTypeNode,
+                                       TypeTreeStorage&   storage);
+  static CppTypeTreeNode& addTypeNode(const CppObj*       cppObj,
+                                      const std::string& name,
+                                      CppTypeTreeNode*   parentTypeNode,
+                                      TypeTreeStorage&   storage);
+  static void             mergeTypeNode(CppTypeTreeNode&          from,
+                                        CppTypeTreeNode*          into,
+                                        CppTypeNodeRelocationMap& relocatedNodes);
+
+  static size_t           shardOf(const void* key);
+
+  void addTypeTreeStorages(const std::vector<TypeTreeStorage*>&    storages,
+                           const std::vector<const CppCompound*>& fileAsts,
+                           unsigned                               numThreads);
+  void loadFileTypes(const std::vector<const CppCompound*>& fileAsts, unsigned numThreads);
+  void unloadFileTypes(const CppCompound* fileAst);
+
+  std::vector<char>          readFile(const std::string& file, FileState& fileState) const;
+  CppCompoundPtr             parseFile(const std::string& file, FileState& fileState);
+  CppCompoundArray::iterator findFileAst(const std::string& file);
+  void                       recordParseStats(const CppCompound* fileAst);
+
+  const CppTypeTreeNode* findTypeNodeNoCache(boost::string_view name, const CppTypeTreeNode* beginFrom) const;
+  void                   invalidateTypeLookups(const std::vector<const CppCompound*>& fileAsts);
+  void                   clearTypeLookupCache();
+  void                   indexFiles(const std::vector<const CppCompound*>& fileAsts);
+  void                   unindexFile(const CppCompound* fileAst);
 
 private:
-  using CppObjToTypeNodeMap = std::map<const CppObj*, CppTypeTreeNode*>;
+  using CppTypeLookupKey = std::pair<const CppTypeTreeNode*, boost::string_view>;
+  struct CppTypeLookupKeyHash
+  {
+    std::size_t operator()(const CppTypeLookupKey& key) const
+    {
+      auto seed = CppTypeNameHash()(key.second);
+      boost::hash_combine(seed, key.first);
+      return seed;
+    }
+  };
+  using CppTypeLookupCache = std::unordered_map<CppTypeLookupKey, const CppTypeTreeNode*, CppTypeLookupKeyHash>;
 
   CppCompoundArray            fileAsts_;        ///< Array of all top level ASTs corresponding to files.
   CppTypeTreeNode             cppTypeTreeRoot_; ///< Repository of all compound objects arranged as type-tree.
-  mutable CppObjToTypeNodeMap cppObjToTypeNode_;
-  CppParser                   parser_;
+  /// Sharded by shardOf() of object.
+  std::array<CppObjToTypeNodeMap, kNumShards> cppObjToTypeNode_;
+  CppParser                                   parser_;
+
+  std::unordered_map<const CppCompound*, FileState>      fileStates_;
+  std::unordered_map<const CppCompound*, CppParserStats> fileParseStats_;
+  /// Objects that each file has added to the type-tree, needed to remove them when file changes.
+  std::unordered_map<const CppCompound*, std::vector<const CppObj*>> fileTypeObjs_;
+  /// All objects of a type node, sharded by shardOf() of node. cppObjSet of the node keeps only one object of each type.
+  std::array<CppTypeNodeObjsMap, kNumShards> typeNodeObjs_;
+  size_t                                     numLoadedTypeObjs_ = 0; ///< Gives the order of loading of objects.
+
+  mutable std::shared_timed_mutex typeLookupCacheMutex_;
+  mutable CppTypeLookupCache typeLookupCache_; ///< Result of findTypeNode(), nullptr for failed search.
+  /// Storage for names used in keys of typeLookupCache_ that are not same as name of the found node.
+  mutable std::deque<std::string> typeLookupCacheNames_;
+
+  mutable std::mutex                      symbolIndexMutex_;
+  mutable std::unique_ptr<CppSymbolIndex> symbolIndex_;
+
+  std::vector<std::string>                 includeRoots_;
+  mutable std::mutex                       includeGraphMutex_;
+  mutable std::unique_ptr<CppIncludeGraph> includeGraph_;
 };
 
 inline const CppCompoundArray& CppProgram::getFileAsts() const
@@ -110,8 +276,21 @@ inline const CppCompoundArray& CppProgram::getFileAsts() const
   return fileAsts_;
 }
 
+inline const std::vector<std::string>& CppProgram::includeRoots() const
+{
+  return includeRoots_;
+}
+
+inline size_t CppProgram::shardOf(const void* key)
+{
+  // Low bits of an address are mostly zero because of alignment.
+  const auto addr = reinterpret_cast<std::uintptr_t>(key);
+  return static_cast<size_t>((addr >> 4) ^ (addr >> 12)) % kNumShards;
+}
+
 inline const CppTypeTreeNode* CppProgram::typeTreeNodeFromCppObj(const CppObj* cppObj) const
 {
-  CppObjToTypeNodeMap::const_iterator itr = cppObjToTypeNode_.find(cppObj);
-  return itr == cppObjToTypeNode_.end() ? nullptr : itr->second;
+  const auto&                         objToTypeNode = cppObjToTypeNode_[shardOf(cppObj)];
+  CppObjToTypeNodeMap::const_iterator itr           = objToTypeNode.find(cppObj);
+  return itr == objToTypeNode.end() ? nullptr : itr->second;
 }
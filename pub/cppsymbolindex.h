@@ -0,0 +1,99 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "cppast.h"
+
+#include <boost/range/iterator_range.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * \brief A named declaration found in a program.
+ */
+struct CppSymbol
+{
+  std::string        name; ///< Fully qualified name without leading '::'. Macros are not qualified.
+  /**
+   * Object that declares the symbol.
+   * For an enum item it is the enum and for a variable in a list of variables it is the CppVarList.
+   */
+  const CppObj*      obj;
+  const CppCompound* file; ///< AST of file in which the symbol is declared.
+};
+
+using CppSymbolArray = std::vector<CppSymbol>;
+using CppSymbolRange = boost::iterator_range<CppSymbolArray::const_iterator>;
+
+/**
+ * \brief Index of all named declarations of a program.
+ *
+ * Types, functions, constructors, destructors, variables, enum items, and macros are indexed by their fully
+ * qualified names. Symbols are kept sorted by name in a contiguous array so that exact and prefix queries are just
+ * binary searches.
+ * \note Index only refers to objects of ASTs and so it must not outlive them.
+ * \note Symbols of same name that are declared in different files are in the order in which files got added to index.
+ */
+class CppSymbolIndex
+{
+public:
+  CppSymbolIndex() = default;
+  explicit CppSymbolIndex(const std::vector<CppCompoundPtr>& fileAsts);
+
+public:
+  /**
+   * @return All symbols whose fully qualified name is exactly \a name, in the order of declaration.
+   * \note A leading '::' in \a name is ignored.
+   */
+  CppSymbolRange find(boost::string_view name) const;
+  /**
+   * @return All symbols whose fully qualified name starts with \a prefix.
+   */
+  CppSymbolRange findPrefix(boost::string_view prefix) const;
+
+  const CppSymbolArray& symbols() const
+  {
+    return symbols_;
+  }
+
+  /**
+   * Adds symbols of files to index.
+   * \note It costs a merge of whole index and so adding many files at once is cheaper than adding one at a time.
+   */
+  void addFiles(const std::vector<const CppCompound*>& fileAsts);
+  /**
+   * Removes all symbols of a file from index.
+   * \note \a fileAst is only compared with CppSymbol::file and so it can be called even after the AST is gone.
+   */
+  void removeFile(const CppCompound* fileAst);
+
+private:
+  void addSymbols(const CppCompound* compound, const std::string& scope, const CppCompound* file);
+  void addSymbol(const std::string& scope, const std::string& name, const CppObj* obj, const CppCompound* file);
+
+private:
+  CppSymbolArray symbols_;
+};
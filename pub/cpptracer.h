@@ -0,0 +1,139 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief Recorder of begin and end events of phases of parsing and emission.
+ *
+ * Events are written as Chrome trace-event JSON that can be loaded in chrome://tracing or Perfetto UI.
+ * Each thread that records events gets its own track.
+ * Phases that happen too often to be recorded every time, like lexing of a token and trial parses, are recorded
+ * only when they take at least minDuration().
+ * \note It is safe to record events concurrently from multiple threads.
+ */
+class CppTracer
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Event
+  {
+    const char*       name;  ///< Expected to be a string literal.
+    char              phase; ///< 'B' for begin and 'E' for end.
+    Clock::time_point time;
+    std::uint32_t     tid; ///< Index of thread, see threadNames().
+    std::string       file;
+    std::size_t       numBytes;
+  };
+
+public:
+  explicit CppTracer(Clock::duration minDuration = std::chrono::microseconds(100));
+
+public:
+  void begin(const char* name, std::string file = std::string(), std::size_t numBytes = 0);
+  /// \note Events of a thread must be ended in reverse order of their beginning.
+  void end(const char* name, std::size_t numBytes = 0);
+  /**
+   * Records a phase that has already ended, but only if it took at least minDuration().
+   */
+  void recordIfSlow(const char* name, Clock::time_point startTime, Clock::time_point endTime = Clock::now());
+  /// Names the track of calling thread.
+  void threadName(std::string name);
+
+  Clock::duration minDuration() const
+  {
+    return minDuration_;
+  }
+
+  /// \note Events must not be recorded while they are being read.
+  const std::vector<Event>& events() const
+  {
+    return events_;
+  }
+  const std::vector<std::string>& threadNames() const
+  {
+    return threadNames_;
+  }
+
+  void writeJson(std::ostream& stm) const;
+  bool writeJson(const std::string& path) const;
+
+private:
+  std::uint32_t threadIdx();
+
+private:
+  const Clock::duration   minDuration_;
+  const Clock::time_point startTime_;
+
+  std::mutex                   mutex_;
+  std::vector<Event>           events_;
+  std::vector<std::thread::id> threadIds_; ///< Index of thread is the index in this vector.
+  std::vector<std::string>     threadNames_;
+};
+
+/**
+ * \brief Records begin of a phase on construction and its end on destruction.
+ * \note It does nothing if tracer is nullptr.
+ */
+class CppTraceScope
+{
+public:
+  CppTraceScope(CppTracer* tracer, const char* name, std::string file = std::string(), std::size_t numBytes = 0)
+    : tracer_(tracer)
+    , name_(name)
+  {
+    if (tracer_)
+      tracer_->begin(name_, std::move(file), numBytes);
+  }
+
+  CppTraceScope(const CppTraceScope&) = delete;
+  CppTraceScope& operator=(const CppTraceScope&) = delete;
+
+  ~CppTraceScope()
+  {
+    if (tracer_)
+      tracer_->end(name_, numBytes_);
+  }
+
+  /// Sets size of data that gets known only by the end of phase.
+  void numBytes(std::size_t n)
+  {
+    numBytes_ = n;
+  }
+
+private:
+  CppTracer*  tracer_;
+  const char* name_;
+  std::size_t numBytes_{0};
+};
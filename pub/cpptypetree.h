@@ -25,10 +25,24 @@
 
 #include "cppast.h"
 
-#include <map>
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include <memory>
 #include <set>
+#include <string>
+#include <unordered_map>
 
 struct CppTypeTreeNode;
+
+struct CppTypeNameHash
+{
+  std::size_t operator()(boost::string_view name) const
+  {
+    return boost::hash_range(name.begin(), name.end());
+  }
+};
+
 /**
  * \brief Represents the tree of types in a C++ program.
  *
@@ -37,8 +51,15 @@ struct CppTypeTreeNode;
  * etc. And each of those compound object can form another branch of tree.
  *
  * \note This tree has no relation with inheritance hierarchy.
+ * \note Keys are non-owning views of CppTypeTreeNode::name of the child they map to.
+ * So, looking up a child never needs to allocate memory, and name of a node goes away together with the node.
+ * But a key that is inserted from outside CppProgram, e.g. by children[someStdString] or
+ * children.emplace(someStdString, ...), dangles as soon as that string goes away. Such code must set name of the
+ * child and use it as key, or otherwise keep storage of the name alive for as long as the tree.
+ * \note Children are iterated in unspecified order, not sorted by name as they were when this was a std::map.
+ * Sort the names if order matters.
  */
-using CppTypeTree = std::map<std::string, CppTypeTreeNode>;
+using CppTypeTree = std::unordered_map<boost::string_view, CppTypeTreeNode, CppTypeNameHash>;
 
 struct CppObjSetCmp
 {
@@ -62,6 +83,8 @@ struct CppTypeTreeNode
   CppObjSet        cppObjSet;
   CppTypeTree      children;
   CppTypeTreeNode* parent;
+  /// Storage of key of this node in children of parent, on heap so that it does not move when node moves.
+  std::unique_ptr<const std::string> name;
 
   CppTypeTreeNode()
     : parent(nullptr)
@@ -24,17 +24,26 @@
 #pragma once
 
 #include "cppast.h"
+#include "cppexprpool.h"
 #include "cppindent.h"
 
 #include <string>
+#include <utility>
+#include <vector>
+
+class CppTracer;
 
 //////////////////////////////////////////////////////////////////////////
 
+/// AST to emit and path of file in which it should be emitted.
+using CppEmitJob = std::pair<const CppObj*, std::string>;
+
 /**
  * Responsible for emitting C/C++ source from CppAst data structure.
  * Implementation of emitting various C/C++ objects should never change
  * the style of code generated. Addition of new functionality and bug fixes
  * are allowed but care must be taken not to change the style of emitted code.
+ * \note Emitting keeps no state in the writer, so one writer can emit into different streams concurrently.
  */
 class CppWriter
 {
@@ -132,6 +141,21 @@ public:
   void emitFunctionPtr(const CppFunctionPointer* funcPtrObj, std::ostream& stm, bool skipName, bool emitNewLine) const;
   void emitFunction(const CppFunction* funcObj, std::ostream& stm, bool skipParamName, bool emitNewLine) const;
   void emitConstructor(const CppConstructor* ctorObj, std::ostream& stm, bool skipParamName) const;
+  void emitExpr(const CppExprPool& pool,
+                CppExprPool::Index idx,
+                std::ostream&      stm,
+                CppIndent          indentation = CppIndent()) const;
+
+  /**
+   * Emits each AST into its file, files are emitted concurrently on \a numThreads threads.
+   * Missing folders of output paths are created.
+   * @param numThreads Number of threads to use, 0 means number of hardware threads.
+   * @param tracer Records emission of each file when it is not nullptr.
+   * @return Paths of files that could not be written, in the order of jobs.
+   */
+  std::vector<std::string> emitFiles(const std::vector<CppEmitJob>& jobs,
+                                     unsigned                       numThreads = 0,
+                                     CppTracer*                     tracer     = nullptr) const;
 
 private:
   void emit(const CppObj* cppObj, std::ostream& stm, CppIndent indentation, bool noNewLine) const;
@@ -156,8 +180,6 @@ private:
   void emitVarDecl(std::ostream& stm, const CppVarDecl& varDecl, bool skipName) const;
 
 private:
-  mutable CppIndent preproIndent_;
-
   EmittingType emittingType_;
 };
 
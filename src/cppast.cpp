@@ -29,6 +29,20 @@
 #include "cppobj-accessor.h"
 #include "cppvar-accessor.h"
 
+#include "cppparserstats.h"
+
+extern CppParserStats* gParserStats;
+extern CppCompoundPtr  parseEnumBlob(const std::string& body, const CppObjFactory* objFactory);
+
+CppObj::CppObj(CppObjType type, CppAccessType accessType)
+  : objType_(type)
+  , accessType_(accessType)
+  , owner_(nullptr)
+{
+  if (gParserStats)
+    ++gParserStats->numObjs[static_cast<std::size_t>(type)];
+}
+
 bool CppConstructor::isCopyConstructor() const
 {
   if (isCopyConstructor_)
@@ -97,6 +111,27 @@ bool CppConstructor::isMoveConstructor() const
   return *isMoveConstructor_;
 }
 
+bool CppEnum::isBodyBlob() const
+{
+  return itemList_ && !itemList_->empty() && itemList_->front()->val_
+         && (itemList_->front()->val_->objType_ == CppBlob::kObjectType);
+}
+
+const CppEnumItemList* CppEnum::items(const CppObjFactory* objFactory) const
+{
+  if (!isBodyBlob())
+    return itemList_.get();
+
+  std::call_once(bodyParsed_, [this, objFactory]() {
+    const auto* blob = static_cast<const CppBlob*>(itemList_->front()->val_.get());
+    parsedBody_      = parseEnumBlob(blob->blob_, objFactory);
+  });
+  const auto* cppAst = static_cast<const CppCompound*>(parsedBody_.get());
+  if (!cppAst || cppAst->members().empty() || (cppAst->members().front()->objType_ != CppEnum::kObjectType))
+    return nullptr;
+  return static_cast<const CppEnum*>(cppAst->members().front().get())->itemList_.get();
+}
+
 bool CppCompound::hasPublicVirtualMethod() const
 {
   if (!isClassLike(this))
@@ -0,0 +1,49 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * CPPPARSER_DEBUG_LOG decides if debug logs of lexer and parser are compiled in.
+ * By default they are compiled in only for debug builds.
+ * When they are compiled out lexer and parser do not even check if logging is enabled.
+ */
+#ifndef CPPPARSER_DEBUG_LOG
+#  ifdef NDEBUG
+#    define CPPPARSER_DEBUG_LOG 0
+#  else
+#    define CPPPARSER_DEBUG_LOG 1
+#  endif
+#endif
+
+#if CPPPARSER_DEBUG_LOG
+/**
+ * Formats a message like printf() and passes it to the log sink, see CppParser::logSink().
+ * \note It is safe to call it concurrently from multiple threads.
+ */
+void cppDebugLog(const char* format, ...)
+#  ifdef __GNUC__
+  __attribute__((format(printf, 1, 2)))
+#  endif
+  ;
+#endif
@@ -0,0 +1,176 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cppexprpool.h"
+
+CppExprPool::CppExprPool(const CppCompound* body)
+{
+  if (body)
+    addExprs(body);
+}
+
+CppExprPool::Index CppExprPool::add(const CppExpr* expr)
+{
+  // Children are added before parent so that the nodes remain in post-order.
+  Node node{expr->oper_, expr->flags_, {addAtom(expr->expr1_), addAtom(expr->expr2_), addAtom(expr->expr3_)}};
+  nodes_.push_back(node);
+  exprs_.push_back(expr);
+  return static_cast<Index>(nodes_.size() - 1);
+}
+
+CppExprPool::Atom CppExprPool::addAtom(const CppExprAtom& exprAtom)
+{
+  switch (exprAtom.type)
+  {
+    case CppExprAtom::kAtom:
+    {
+      const auto atom = exprAtom.atom();
+      atomSpans_.emplace_back(static_cast<Index>(atomText_.size()), static_cast<std::uint32_t>(atom.size()));
+      atomText_.append(atom.data(), atom.size());
+      return Atom{exprAtom.type, static_cast<Index>(atomSpans_.size() - 1)};
+    }
+    case CppExprAtom::kExpr:
+      if (exprAtom.expr == nullptr)
+        break;
+      return Atom{exprAtom.type, add(exprAtom.expr)};
+    case CppExprAtom::kLambda:
+      objs_.push_back(exprAtom.lambda);
+      return Atom{exprAtom.type, static_cast<Index>(objs_.size() - 1)};
+    case CppExprAtom::kVarType:
+      objs_.push_back(exprAtom.varType);
+      return Atom{exprAtom.type, static_cast<Index>(objs_.size() - 1)};
+
+    default:
+      break;
+  }
+
+  return Atom{CppExprAtom::kInvalid, kInvalidIndex};
+}
+
+void CppExprPool::addExprs(const CppObj* obj)
+{
+  if (obj == nullptr)
+    return;
+
+  switch (obj->objType_)
+  {
+    case CppObjType::kExpression:
+      roots_.push_back(add(static_cast<const CppExpr*>(obj)));
+      break;
+
+    case CppObjType::kVar:
+    {
+      auto* var = static_cast<const CppVar*>(obj);
+      if (var->assignValue())
+        roots_.push_back(add(var->assignValue()));
+    }
+    break;
+
+    case CppObjType::kVarList:
+    {
+      auto* varList = static_cast<const CppVarList*>(obj);
+      addExprs(varList->firstVar().get());
+      for (const auto& varDecl : varList->varDeclList())
+      {
+        if (varDecl.assignValue())
+          roots_.push_back(add(varDecl.assignValue()));
+      }
+    }
+    break;
+
+    case CppObjType::kCompound:
+      for (const auto& mem : static_cast<const CppCompound*>(obj)->members())
+        addExprs(mem.get());
+      break;
+
+    case CppObjType::kIfBlock:
+    {
+      auto* ifBlock = static_cast<const CppIfBlock*>(obj);
+      addExprs(ifBlock->cond_.get());
+      addExprs(ifBlock->body_.get());
+      addExprs(ifBlock->elsePart());
+    }
+    break;
+
+    case CppObjType::kWhileBlock:
+    {
+      auto* whileBlock = static_cast<const CppWhileBlock*>(obj);
+      addExprs(whileBlock->cond_.get());
+      addExprs(whileBlock->body_.get());
+    }
+    break;
+
+    case CppObjType::kDoWhileBlock:
+    {
+      auto* doBlock = static_cast<const CppDoWhileBlock*>(obj);
+      addExprs(doBlock->body_.get());
+      addExprs(doBlock->cond_.get());
+    }
+    break;
+
+    case CppObjType::kForBlock:
+    {
+      auto* forBlock = static_cast<const CppForBlock*>(obj);
+      addExprs(forBlock->start_.get());
+      addExprs(forBlock->stop_.get());
+      addExprs(forBlock->step_.get());
+      addExprs(forBlock->body_.get());
+    }
+    break;
+
+    case CppObjType::kRangeForBlock:
+    {
+      auto* forBlock = static_cast<const CppRangeForBlock*>(obj);
+      addExprs(forBlock->expr_.get());
+      addExprs(forBlock->body_.get());
+    }
+    break;
+
+    case CppObjType::kSwitchBlock:
+    {
+      auto* switchBlock = static_cast<const CppSwitchBlock*>(obj);
+      addExprs(switchBlock->cond_.get());
+      if (switchBlock->body_)
+      {
+        for (const auto& caseStmt : *(switchBlock->body_))
+        {
+          addExprs(caseStmt.case_.get());
+          addExprs(caseStmt.body_.get());
+        }
+      }
+    }
+    break;
+
+    case CppObjType::kTryBlock:
+    {
+      auto* tryBlock = static_cast<const CppTryBlock*>(obj);
+      addExprs(tryBlock->tryStmt_.get());
+      for (const auto& catchBlock : tryBlock->catchBlocks())
+        addExprs(catchBlock->catchStmt_.get());
+    }
+    break;
+
+    default:
+      break;
+  }
+}
@@ -0,0 +1,304 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cppincludegraph.h"
+
+#include "cppobj-accessor.h"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
+
+namespace fs = boost::filesystem;
+
+static std::string normalizedPath(const fs::path& path)
+{
+  return fs::absolute(path).lexically_normal().generic_string();
+}
+
+// Unlike traverse() it also visits includes that are inside extern "C" blocks.
+static void forEachInclude(const CppCompound* compound, const std::function<void(const CppInclude*)>& visitor)
+{
+  for (const auto& mem : compound->members())
+  {
+    if (mem->objType_ == CppObjType::kHashInclude)
+      visitor(static_cast<const CppInclude*>(mem.get()));
+    else if (isCompound(mem))
+      forEachInclude(static_cast<const CppCompound*>(mem.get()), visitor);
+  }
+}
+
+CppIncludeGraph::CppIncludeGraph(const std::vector<CppCompoundPtr>& fileAsts,
+                                 const std::vector<std::string>&    includeRoots)
+  : includeRoots_(includeRoots)
+{
+  files_.reserve(fileAsts.size());
+  for (const auto& fileAst : fileAsts)
+    addFileNode(fileAst.get());
+  for (size_t i = 0; i < files_.size(); ++i)
+    addIncludes(i);
+  sortTopologically();
+}
+
+void CppIncludeGraph::addFileNode(const CppCompound* fileAst)
+{
+  fileAstToIdx_.emplace(fileAst, files_.size());
+  pathToIdx_.emplace(normalizedPath(fileAst->name()), files_.size());
+  files_.emplace_back(fileAst);
+}
+
+const CppIncludeGraph::FileNode* CppIncludeGraph::resolveInclude(const FileNode&    file,
+                                                                 const std::string& includeName) const
+{
+  if (includeName.size() < 2)
+    return nullptr;
+  // Anything else, e.g. #include SOME_MACRO, cannot be resolved without expanding macros.
+  const auto isQuoted    = (includeName.front() == '"') && (includeName.back() == '"');
+  const auto isBracketed = (includeName.front() == '<') && (includeName.back() == '>');
+  if (!isQuoted && !isBracketed)
+    return nullptr;
+  const auto name = includeName.substr(1, includeName.size() - 2);
+  if (isQuoted)
+  {
+    const auto fileDir = fs::path(file.fileAst->name()).parent_path();
+    auto       itr     = pathToIdx_.find(normalizedPath(fileDir / name));
+    if (itr != pathToIdx_.end())
+      return &files_[itr->second];
+  }
+  for (const auto& includeRoot : includeRoots_)
+  {
+    auto itr = pathToIdx_.find(normalizedPath(fs::path(includeRoot) / name));
+    if (itr != pathToIdx_.end())
+      return &files_[itr->second];
+  }
+  return nullptr;
+}
+
+void CppIncludeGraph::addInclude(size_t fileIdx, const CppInclude* include)
+{
+  auto& file         = files_[fileIdx];
+  auto* includedFile = resolveInclude(file, include->name_);
+  if (includedFile == nullptr)
+  {
+    file.unresolvedIncludes.push_back(include);
+    return;
+  }
+  file.resolvedIncludes.emplace_back(include, includedFile->fileAst);
+  if (std::find(file.includes.begin(), file.includes.end(), includedFile->fileAst) == file.includes.end())
+  {
+    file.includes.push_back(includedFile->fileAst);
+    files_[fileAstToIdx_[includedFile->fileAst]].includedBy.push_back(file.fileAst);
+  }
+}
+
+void CppIncludeGraph::addIncludes(size_t fileIdx)
+{
+  forEachInclude(files_[fileIdx].fileAst, [&](const CppInclude* include) { addInclude(fileIdx, include); });
+}
+
+// File name that an #include refers to, empty if it cannot refer to any file.
+static std::string includedFileName(const std::string& includeName)
+{
+  if (includeName.size() < 2)
+    return std::string();
+  return fs::path(includeName.substr(1, includeName.size() - 2)).filename().string();
+}
+
+void CppIncludeGraph::addFiles(const CppFileAstArray& fileAsts)
+{
+  const auto numOldFiles = files_.size();
+  for (const auto* fileAst : fileAsts)
+    addFileNode(fileAst);
+  for (size_t i = numOldFiles; i < files_.size(); ++i)
+    addIncludes(i);
+
+  // An include that could not be resolved before can only resolve to a new file.
+  // Comparing file names first saves resolving paths of includes, like those of system headers, that cannot match.
+  std::unordered_set<std::string> newFileNames;
+  for (size_t i = numOldFiles; i < files_.size(); ++i)
+    newFileNames.insert(fs::path(files_[i].fileAst->name()).filename().string());
+  for (size_t i = 0; i < numOldFiles; ++i)
+  {
+    CppIncludeArray unresolvedIncludes;
+    unresolvedIncludes.swap(files_[i].unresolvedIncludes);
+    for (const auto* include : unresolvedIncludes)
+    {
+      if (newFileNames.count(includedFileName(include->name_)))
+        addInclude(i, include);
+      else
+        files_[i].unresolvedIncludes.push_back(include);
+    }
+  }
+
+  topologicalOrder_.clear();
+  sortTopologically();
+}
+
+void CppIncludeGraph::removeFile(const CppCompound* fileAst)
+{
+  auto fileItr = fileAstToIdx_.find(fileAst);
+  if (fileItr == fileAstToIdx_.end())
+    return;
+  const auto fileIdx = fileItr->second;
+
+  auto erase = [fileAst](CppFileAstArray& files) {
+    files.erase(std::remove(files.begin(), files.end(), fileAst), files.end());
+  };
+  for (const auto* includedFile : files_[fileIdx].includes)
+  {
+    if (includedFile != fileAst)
+      erase(files_[fileAstToIdx_.at(includedFile)].includedBy);
+  }
+  // Includes of other files that resolved to the removed one may resolve to some other file now.
+  std::vector<std::pair<const CppCompound*, const CppInclude*>> includesToResolve;
+  for (const auto* includer : files_[fileIdx].includedBy)
+  {
+    if (includer == fileAst)
+      continue;
+    auto& includerNode = files_[fileAstToIdx_.at(includer)];
+    erase(includerNode.includes);
+    auto& resolvedIncludes = includerNode.resolvedIncludes;
+    for (const auto& resolvedInclude : resolvedIncludes)
+    {
+      if (resolvedInclude.second == fileAst)
+        includesToResolve.emplace_back(includer, resolvedInclude.first);
+    }
+    resolvedIncludes.erase(std::remove_if(resolvedIncludes.begin(),
+                                          resolvedIncludes.end(),
+                                          [fileAst](const std::pair<const CppInclude*, const CppCompound*>& include) {
+                                            return include.second == fileAst;
+                                          }),
+                           resolvedIncludes.end());
+  }
+
+  files_.erase(files_.begin() + fileIdx);
+  fileAstToIdx_.erase(fileItr);
+  for (auto& fileAstAndIdx : fileAstToIdx_)
+  {
+    if (fileAstAndIdx.second > fileIdx)
+      --fileAstAndIdx.second;
+  }
+  for (auto itr = pathToIdx_.begin(); itr != pathToIdx_.end();)
+  {
+    if (itr->second == fileIdx)
+    {
+      itr = pathToIdx_.erase(itr);
+      continue;
+    }
+    if (itr->second > fileIdx)
+      --itr->second;
+    ++itr;
+  }
+
+  for (const auto& includerAndInclude : includesToResolve)
+    addInclude(fileAstToIdx_.at(includerAndInclude.first), includerAndInclude.second);
+
+  topologicalOrder_.clear();
+  sortTopologically();
+}
+
+void CppIncludeGraph::sortTopologically()
+{
+  enum VisitState
+  {
+    kNotVisited,
+    kVisiting,
+    kVisited
+  };
+  std::vector<VisitState> visitStates(files_.size(), kNotVisited);
+
+  std::function<void(size_t)> visit = [&](size_t fileIdx) {
+    if (visitStates[fileIdx] != kNotVisited)
+      return; // Either already ordered or it is a cyclic include.
+    visitStates[fileIdx] = kVisiting;
+    for (const auto* includedFile : files_[fileIdx].includes)
+      visit(fileAstToIdx_.at(includedFile));
+    visitStates[fileIdx]             = kVisited;
+    files_[fileIdx].topologicalIndex = topologicalOrder_.size();
+    topologicalOrder_.push_back(files_[fileIdx].fileAst);
+  };
+
+  topologicalOrder_.reserve(files_.size());
+  for (size_t i = 0; i < files_.size(); ++i)
+    visit(i);
+}
+
+const CppIncludeGraph::FileNode* CppIncludeGraph::fileNode(const CppCompound* fileAst) const
+{
+  auto itr = fileAstToIdx_.find(fileAst);
+  return (itr == fileAstToIdx_.end()) ? nullptr : &files_[itr->second];
+}
+
+const CppFileAstArray& CppIncludeGraph::includes(const CppCompound* fileAst) const
+{
+  static const CppFileAstArray kNoFiles;
+  auto*                        node = fileNode(fileAst);
+  return node ? node->includes : kNoFiles;
+}
+
+const CppFileAstArray& CppIncludeGraph::includedBy(const CppCompound* fileAst) const
+{
+  static const CppFileAstArray kNoFiles;
+  auto*                        node = fileNode(fileAst);
+  return node ? node->includedBy : kNoFiles;
+}
+
+const CppIncludeArray& CppIncludeGraph::unresolvedIncludes(const CppCompound* fileAst) const
+{
+  static const CppIncludeArray kNoIncludes;
+  auto*                        node = fileNode(fileAst);
+  return node ? node->unresolvedIncludes : kNoIncludes;
+}
+
+CppFileAstArray CppIncludeGraph::dependents(const CppCompound* fileAst) const
+{
+  CppFileAstArray dependentFiles;
+  auto*           node = fileNode(fileAst);
+  if (node == nullptr)
+    return dependentFiles;
+
+  std::vector<bool> seen(files_.size(), false);
+  seen[fileAstToIdx_.at(fileAst)] = true;
+  std::vector<const FileNode*> toVisit(1, node);
+  while (!toVisit.empty())
+  {
+    auto* current = toVisit.back();
+    toVisit.pop_back();
+    for (const auto* includer : current->includedBy)
+    {
+      const auto idx = fileAstToIdx_.at(includer);
+      if (seen[idx])
+        continue;
+      seen[idx] = true;
+      dependentFiles.push_back(includer);
+      toVisit.push_back(&files_[idx]);
+    }
+  }
+
+  std::sort(dependentFiles.begin(), dependentFiles.end(), [this](const CppCompound* lhs, const CppCompound* rhs) {
+    return fileNode(lhs)->topologicalIndex < fileNode(rhs)->topologicalIndex;
+  });
+  return dependentFiles;
+}
@@ -0,0 +1,498 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cppmemoryreport.h"
+#include "cppcompound-accessor.h"
+#include "cppprog.h"
+
+namespace {
+
+/// @return true if \a p points inside the object \a obj, e.g. when text is stored in small buffer of a string.
+template <typename _T>
+bool isInside(const char* p, const _T& obj)
+{
+  const auto* begin = reinterpret_cast<const char*>(&obj);
+  return (p >= begin) && (p < begin + sizeof(_T));
+}
+
+std::size_t heapBytes(const std::string& str)
+{
+  return isInside(str.data(), str) ? 0 : str.capacity() + 1;
+}
+
+template <typename _T>
+std::size_t heapBytes(const std::vector<_T>& vec)
+{
+  return vec.capacity() * sizeof(_T);
+}
+
+std::size_t heapBytes(const CppIdentifierList& identifiers)
+{
+  auto numBytes = identifiers.capacity() * sizeof(std::string);
+  for (const auto& identifier : identifiers)
+    numBytes += heapBytes(identifier);
+  return numBytes;
+}
+
+} // namespace
+
+CppMemoryReport::CppMemoryReport(const CppCompound* fileAst)
+{
+  addFile(fileAst);
+}
+
+CppMemoryReport::CppMemoryReport(const CppProgram& program)
+{
+  for (const auto& fileAst : program.getFileAsts())
+    addFile(fileAst.get());
+}
+
+void CppMemoryReport::addFile(const CppCompound* fileAst)
+{
+  if (fileAst == nullptr)
+    return;
+  add(fileAst, Accounts{&byFile_[fileAst->name()], &byNamespace_[std::string()], true});
+}
+
+CppMemoryUsage CppMemoryReport::total() const
+{
+  CppMemoryUsage usage;
+  for (const auto& typeUsage : byType_)
+    usage += typeUsage;
+  return usage;
+}
+
+void CppMemoryReport::record(CppObjType objType, std::size_t numBytes, const Accounts& accounts)
+{
+  const CppMemoryUsage usage{1, numBytes};
+  byType_[static_cast<std::size_t>(objType)] += usage;
+  *accounts.file += usage;
+  *accounts.topNamespace += usage;
+}
+
+void CppMemoryReport::add(const CppObj* obj, const Accounts& accounts)
+{
+  if (obj == nullptr)
+    return;
+
+  std::size_t numBytes = 0;
+  switch (obj->objType_)
+  {
+    case CppObjType::kDocComment:
+      numBytes = sizeof(CppDocComment) + heapBytes(static_cast<const CppDocComment*>(obj)->doc_);
+      break;
+
+    case CppObjType::kHashIf:
+      numBytes = sizeof(CppHashIf) + heapBytes(static_cast<const CppHashIf*>(obj)->cond_);
+      break;
+
+    case CppObjType::kHashInclude:
+      numBytes = sizeof(CppInclude) + heapBytes(static_cast<const CppInclude*>(obj)->name_);
+      break;
+
+    case CppObjType::kHashImport:
+      numBytes = sizeof(CppImport) + heapBytes(static_cast<const CppImport*>(obj)->name_);
+      break;
+
+    case CppObjType::kHashDefine:
+    {
+      auto* def = static_cast<const CppDefine*>(obj);
+      numBytes  = sizeof(CppDefine) + heapBytes(def->name_) + heapBytes(def->defn_);
+    }
+    break;
+
+    case CppObjType::kHashUndef:
+      numBytes = sizeof(CppUndef) + heapBytes(static_cast<const CppUndef*>(obj)->name_);
+      break;
+
+    case CppObjType::kHashPragma:
+      numBytes = sizeof(CppPragma) + heapBytes(static_cast<const CppPragma*>(obj)->defn_);
+      break;
+
+    case CppObjType::kHashError:
+      numBytes = sizeof(CppHashError) + heapBytes(static_cast<const CppHashError*>(obj)->err_);
+      break;
+
+    case CppObjType::kUnRecogPrePro:
+    {
+      auto* prepro = static_cast<const CppUnRecogPrePro*>(obj);
+      numBytes     = sizeof(CppUnRecogPrePro) + heapBytes(prepro->name_) + heapBytes(prepro->defn_);
+    }
+    break;
+
+    case CppObjType::kVarType:
+    {
+      auto* varType = static_cast<const CppVarType*>(obj);
+      numBytes      = sizeof(CppVarType) + heapBytes(varType->baseType());
+      add(varType->compound(), accounts);
+    }
+    break;
+
+    case CppObjType::kVar:
+    {
+      auto* var = static_cast<const CppVar*>(obj);
+      numBytes  = sizeof(CppVar) + heapBytes(var->apidecor()) + varDeclBytes(var->varDecl(), accounts);
+      add(var->varType(), accounts);
+    }
+    break;
+
+    case CppObjType::kVarList:
+    {
+      auto* varList = static_cast<const CppVarList*>(obj);
+      numBytes      = sizeof(CppVarList) + heapBytes(varList->varDeclList());
+      for (const auto& varDecl : varList->varDeclList())
+        numBytes += varDeclBytes(varDecl, accounts);
+      add(varList->firstVar().get(), accounts);
+    }
+    break;
+
+    case CppObjType::kTypedefName:
+      numBytes = sizeof(CppTypedefName);
+      add(static_cast<const CppTypedefName*>(obj)->var_.get(), accounts);
+      break;
+
+    case CppObjType::kTypedefNameList:
+      numBytes = sizeof(CppTypedefList);
+      add(static_cast<const CppTypedefList*>(obj)->varList_.get(), accounts);
+      break;
+
+    case CppObjType::kNamespaceAlias:
+    {
+      auto* alias = static_cast<const CppNamespaceAlias*>(obj);
+      numBytes    = sizeof(CppNamespaceAlias) + heapBytes(alias->name_) + heapBytes(alias->alias_);
+    }
+    break;
+
+    case CppObjType::kUsingNamespaceDecl:
+      numBytes = sizeof(CppUsingNamespaceDecl) + heapBytes(static_cast<const CppUsingNamespaceDecl*>(obj)->name_);
+      break;
+
+    case CppObjType::kUsingDecl:
+    {
+      auto* usingDecl = static_cast<const CppUsingDecl*>(obj);
+      numBytes        = sizeof(CppUsingDecl) + heapBytes(usingDecl->name_)
+                 + templateParamListBytes(usingDecl->templateParamList(), accounts);
+      add(usingDecl->cppObj_.get(), accounts);
+    }
+    break;
+
+    case CppObjType::kEnum:
+    {
+      auto* enumObj = static_cast<const CppEnum*>(obj);
+      numBytes      = sizeof(CppEnum) + heapBytes(enumObj->name_) + heapBytes(enumObj->underlyingType_);
+      if (enumObj->itemList_)
+      {
+        numBytes += sizeof(CppEnumItemList) + heapBytes(*(enumObj->itemList_));
+        for (const auto& enumItem : *(enumObj->itemList_))
+        {
+          numBytes += sizeof(CppEnumItem) + heapBytes(enumItem->name_);
+          add(enumItem->val_.get(), accounts);
+        }
+      }
+    }
+    break;
+
+    case CppObjType::kCompound:
+      numBytes = compoundBytes(static_cast<const CppCompound*>(obj), accounts);
+      break;
+
+    case CppObjType::kFwdClsDecl:
+    {
+      auto* fwdCls = static_cast<const CppFwdClsDecl*>(obj);
+      numBytes     = sizeof(CppFwdClsDecl) + heapBytes(fwdCls->name_) + heapBytes(fwdCls->apidecor_)
+                 + templateParamListBytes(fwdCls->templateParamList(), accounts);
+    }
+    break;
+
+    case CppObjType::kFunction:
+    {
+      auto* func = static_cast<const CppFunction*>(obj);
+      numBytes   = sizeof(CppFunction) + functionBaseBytes(func, accounts) + paramsBytes(func->params(), accounts);
+      add(func->retType_.get(), accounts);
+    }
+    break;
+
+    case CppObjType::kFunctionPtr:
+    {
+      auto* func = static_cast<const CppFunctionPointer*>(obj);
+      numBytes   = sizeof(CppFunctionPointer) + heapBytes(func->ownerName_) + functionBaseBytes(func, accounts)
+                 + paramsBytes(func->params(), accounts);
+      add(func->retType_.get(), accounts);
+    }
+    break;
+
+    case CppObjType::kLambda:
+    {
+      auto* lambda = static_cast<const CppLambda*>(obj);
+      numBytes     = sizeof(CppLambda) + funcLikeBytes(lambda, accounts) + paramsBytes(lambda->params_.get(), accounts);
+      add(lambda->captures_.get(), accounts);
+      add(lambda->retType_.get(), accounts);
+      add(lambda->defn_.get(), accounts);
+    }
+    break;
+
+    case CppObjType::kConstructor:
+    {
+      auto* ctor = static_cast<const CppConstructor*>(obj);
+      numBytes   = sizeof(CppConstructor) + functionBaseBytes(ctor, accounts) + paramsBytes(ctor->params(), accounts);
+      if (ctor->memInitList_)
+      {
+        numBytes += sizeof(CppMemInitList) + heapBytes(*(ctor->memInitList_));
+        for (const auto& memInit : *(ctor->memInitList_))
+        {
+          numBytes += heapBytes(memInit.first);
+          add(memInit.second.get(), accounts);
+        }
+      }
+    }
+    break;
+
+    case CppObjType::kDestructor:
+      numBytes = sizeof(CppDestructor) + functionBaseBytes(static_cast<const CppDestructor*>(obj), accounts);
+      break;
+
+    case CppObjType::kTypeConverter:
+    {
+      auto* typeConverter = static_cast<const CppTypeConverter*>(obj);
+      numBytes            = sizeof(CppTypeConverter) + functionBaseBytes(typeConverter, accounts);
+      add(typeConverter->to_.get(), accounts);
+    }
+    break;
+
+    case CppObjType::kExpression:
+    {
+      auto* expr = static_cast<const CppExpr*>(obj);
+      numBytes   = sizeof(CppExpr) + exprAtomBytes(expr->expr1_, accounts) + exprAtomBytes(expr->expr2_, accounts)
+                 + exprAtomBytes(expr->expr3_, accounts);
+    }
+    break;
+
+    case CppObjType::kMacroCall:
+      numBytes = sizeof(CppMacroCall) + heapBytes(static_cast<const CppMacroCall*>(obj)->macroCall_);
+      break;
+
+    case CppObjType::kAsmBlock:
+      numBytes = sizeof(CppAsmBlock) + heapBytes(static_cast<const CppAsmBlock*>(obj)->asm_);
+      break;
+
+    case CppObjType::kBlob:
+      numBytes = sizeof(CppBlob) + heapBytes(static_cast<const CppBlob*>(obj)->blob_);
+      break;
+
+    case CppObjType::kIfBlock:
+    {
+      auto* ifBlock = static_cast<const CppIfBlock*>(obj);
+      numBytes      = sizeof(CppIfBlock);
+      add(ifBlock->cond_.get(), accounts);
+      add(ifBlock->body_.get(), accounts);
+      add(ifBlock->elsePart(), accounts);
+    }
+    break;
+
+    case CppObjType::kWhileBlock:
+    {
+      auto* whileBlock = static_cast<const CppWhileBlock*>(obj);
+      numBytes         = sizeof(CppWhileBlock);
+      add(whileBlock->cond_.get(), accounts);
+      add(whileBlock->body_.get(), accounts);
+    }
+    break;
+
+    case CppObjType::kDoWhileBlock:
+    {
+      auto* doBlock = static_cast<const CppDoWhileBlock*>(obj);
+      numBytes      = sizeof(CppDoWhileBlock);
+      add(doBlock->cond_.get(), accounts);
+      add(doBlock->body_.get(), accounts);
+    }
+    break;
+
+    case CppObjType::kForBlock:
+    {
+      auto* forBlock = static_cast<const CppForBlock*>(obj);
+      numBytes       = sizeof(CppForBlock);
+      add(forBlock->start_.get(), accounts);
+      add(forBlock->stop_.get(), accounts);
+      add(forBlock->step_.get(), accounts);
+      add(forBlock->body_.get(), accounts);
+    }
+    break;
+
+    case CppObjType::kRangeForBlock:
+    {
+      auto* forBlock = static_cast<const CppRangeForBlock*>(obj);
+      numBytes       = sizeof(CppRangeForBlock);
+      add(forBlock->var_.get(), accounts);
+      add(forBlock->expr_.get(), accounts);
+      add(forBlock->body_.get(), accounts);
+    }
+    break;
+
+    case CppObjType::kSwitchBlock:
+    {
+      auto* switchBlock = static_cast<const CppSwitchBlock*>(obj);
+      numBytes          = sizeof(CppSwitchBlock);
+      add(switchBlock->cond_.get(), accounts);
+      if (switchBlock->body_)
+      {
+        numBytes += sizeof(CppSwitchBody) + heapBytes(*(switchBlock->body_));
+        for (const auto& caseStmt : *(switchBlock->body_))
+        {
+          add(caseStmt.case_.get(), accounts);
+          add(caseStmt.body_.get(), accounts);
+        }
+      }
+    }
+    break;
+
+    case CppObjType::kTryBlock:
+    {
+      auto* tryBlock = static_cast<const CppTryBlock*>(obj);
+      numBytes       = sizeof(CppTryBlock) + heapBytes(tryBlock->catchBlocks());
+      add(tryBlock->tryStmt_.get(), accounts);
+      for (const auto& catchBlock : tryBlock->catchBlocks())
+      {
+        numBytes += sizeof(CppCatchBlock) + heapBytes(catchBlock->exceptionName_);
+        add(catchBlock->exceptionType_.get(), accounts);
+        add(catchBlock->catchStmt_.get(), accounts);
+      }
+    }
+    break;
+
+    default:
+      numBytes = sizeof(CppObj);
+      break;
+  }
+
+  record(obj->objType_, numBytes, accounts);
+}
+
+std::size_t CppMemoryReport::compoundBytes(const CppCompound* compound, const Accounts& accounts)
+{
+  auto numBytes = sizeof(CppCompound) + heapBytes(compound->name()) + heapBytes(compound->apidecor())
+                  + heapBytes(compound->members()) + heapBytes(compound->ctors())
+                  + templateParamListBytes(compound->templateParamList(), accounts);
+  if (compound->inheritanceList())
+  {
+    numBytes += sizeof(CppInheritanceList) + heapBytes(*(compound->inheritanceList()));
+    for (const auto& inheritInfo : *(compound->inheritanceList()))
+      numBytes += heapBytes(inheritInfo.baseName);
+  }
+
+  const Accounts memAccounts{accounts.file, accounts.topNamespace, false};
+  for (const auto& mem : compound->members())
+  {
+    // Namespaces at file scope start their own account and rest of the members stay in account of file scope.
+    if (accounts.atFileScope && (mem->objType_ == CppObjType::kCompound)
+        && isNamespace(static_cast<const CppCompound*>(mem.get())))
+    {
+      const auto& name = static_cast<const CppCompound*>(mem.get())->name();
+      add(mem.get(), Accounts{accounts.file, &byNamespace_[name], false});
+    }
+    else
+    {
+      add(mem.get(), memAccounts);
+    }
+  }
+
+  return numBytes;
+}
+
+std::size_t CppMemoryReport::varDeclBytes(const CppVarDecl& varDecl, const Accounts& accounts)
+{
+  add(varDecl.assignValue(), accounts);
+  add(varDecl.bitField(), accounts);
+  for (const auto& arraySize : varDecl.arraySizes())
+    add(arraySize.get(), accounts);
+
+  return heapBytes(varDecl.name()) + heapBytes(varDecl.arraySizes());
+}
+
+std::size_t CppMemoryReport::exprAtomBytes(const CppExprAtom& exprAtom, const Accounts& accounts)
+{
+  switch (exprAtom.type)
+  {
+    case CppExprAtom::kAtom:
+    {
+      // Only long texts are allocated, short ones are stored inside the atom itself.
+      const auto atom = exprAtom.atom();
+      return isInside(atom.data(), exprAtom) ? 0 : atom.size();
+    }
+    case CppExprAtom::kExpr:
+      add(exprAtom.expr, accounts);
+      break;
+    case CppExprAtom::kLambda:
+      add(exprAtom.lambda, accounts);
+      break;
+    case CppExprAtom::kVarType:
+      add(exprAtom.varType, accounts);
+      break;
+
+    default:
+      break;
+  }
+
+  return 0;
+}
+
+std::size_t CppMemoryReport::templateParamListBytes(const CppTemplateParamList* templParamList,
+                                                    const Accounts&             accounts)
+{
+  if (templParamList == nullptr)
+    return 0;
+
+  auto numBytes = sizeof(CppTemplateParamList) + heapBytes(*templParamList);
+  for (const auto& templParam : *templParamList)
+  {
+    numBytes += sizeof(CppTemplateParam) + heapBytes(templParam->paramName_);
+    add(templParam->paramType_.get(), accounts);
+    add(templParam->defaultArg(), accounts);
+  }
+
+  return numBytes;
+}
+
+std::size_t CppMemoryReport::paramsBytes(const CppParamVector* params, const Accounts& accounts)
+{
+  if (params == nullptr)
+    return 0;
+
+  for (const auto& param : *params)
+    add(param.get(), accounts);
+
+  return sizeof(CppParamVector) + heapBytes(*params);
+}
+
+std::size_t CppMemoryReport::funcLikeBytes(const CppFuncLikeBase* func, const Accounts& accounts)
+{
+  add(func->defn(), accounts);
+  if (func->throwSpec() == nullptr)
+    return 0;
+  return sizeof(CppFuncThrowSpec) + heapBytes(*(func->throwSpec()));
+}
+
+std::size_t CppMemoryReport::functionBaseBytes(const CppFunctionBase* func, const Accounts& accounts)
+{
+  return funcLikeBytes(func, accounts) + heapBytes(func->name_) + heapBytes(func->decor1())
+         + heapBytes(func->decor2()) + templateParamListBytes(func->templateParamList(), accounts);
+}
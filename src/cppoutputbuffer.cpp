@@ -0,0 +1,70 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cppoutputbuffer.h"
+
+#include <algorithm>
+#include <cstdio>
+
+CppOutputBuffer::CppOutputBuffer(size_t initialCapacity)
+  : buffer_(std::max<size_t>(initialCapacity, 1))
+{
+  setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+const int CppOutputStream::kBufferIdx = std::ios_base::xalloc();
+
+void CppOutputBuffer::reserve(size_t len)
+{
+  const auto currSize = size();
+  buffer_.resize(std::max(buffer_.size() * 2, currSize + len));
+  setp(buffer_.data(), buffer_.data() + buffer_.size());
+  pbump(static_cast<int>(currSize));
+}
+
+CppOutputBuffer::int_type CppOutputBuffer::overflow(int_type c)
+{
+  if (!traits_type::eq_int_type(c, traits_type::eof()))
+    append(traits_type::to_char_type(c));
+  return traits_type::not_eof(c);
+}
+
+std::streamsize CppOutputBuffer::xsputn(const char* str, std::streamsize len)
+{
+  append(str, static_cast<size_t>(len));
+  return len;
+}
+
+void CppOutputBuffer::writeTo(std::ostream& stm) const
+{
+  stm.write(data(), size());
+}
+
+bool CppOutputBuffer::writeToFile(const std::string& filePath) const
+{
+  auto* fp = std::fopen(filePath.c_str(), "wb");
+  if (fp == nullptr)
+    return false;
+  const auto numWritten = std::fwrite(data(), 1, size(), fp);
+  return (std::fclose(fp) == 0) && (numWritten == size());
+}
@@ -0,0 +1,51 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/// Calls task(i) for every i in [0, numTasks) using \a numThreads threads, 0 means number of hardware threads.
+template <typename Task>
+void runInParallel(size_t numTasks, unsigned numThreads, const Task& task)
+{
+  if (numThreads == 0)
+    numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  numThreads = static_cast<unsigned>(std::min<size_t>(numThreads, numTasks));
+
+  std::atomic<size_t> nextTask(0);
+  auto                runTasks = [&]() {
+    for (size_t i = nextTask++; i < numTasks; i = nextTask++)
+      task(i);
+  };
+  std::vector<std::thread> workers;
+  for (unsigned i = 1; i < numThreads; ++i)
+    workers.emplace_back(runTasks);
+  runTasks();
+  for (auto& worker : workers)
+    worker.join();
+}
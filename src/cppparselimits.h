@@ -0,0 +1,81 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "cppparsecontrol.h"
+#include "cppparser.h"
+
+#include <chrono>
+#include <cstddef>
+
+/**
+ * Limits of one parsing, lexer checks them before each token and parser before each trial parse.
+ * Once a limit is hit it stays hit till end of parsing and status tells which one it was.
+ */
+struct CppParseLimits
+{
+  /// Clock and allocation counter are read only once in this many checks, except on start of a trial parse.
+  static constexpr unsigned kCheckInterval = 64;
+
+  const CppCancellationToken*           cancellationToken = nullptr;
+  std::chrono::steady_clock::time_point deadline          = std::chrono::steady_clock::time_point::max();
+  CppParser::AllocationCounter          allocationCounter = nullptr;
+  std::size_t                           maxAllocations    = 0; ///< Value of allocationCounter at which parsing stops.
+  unsigned                              numChecks         = 0;
+  CppParseStatus                        status            = CppParseStatus::kSuccess;
+
+  bool isHit() const
+  {
+    return status != CppParseStatus::kSuccess;
+  }
+
+  /// @return true if parsing should stop. \a always forces check of time and allocations.
+  bool check(bool always)
+  {
+    if (isHit())
+      return true;
+    if (cancellationToken && cancellationToken->isCancelled())
+      status = CppParseStatus::kCancelled;
+    else if (!always && (++numChecks % kCheckInterval))
+      return false;
+    else if (std::chrono::steady_clock::now() >= deadline)
+      status = CppParseStatus::kTimeBudgetExceeded;
+    else if (allocationCounter && (allocationCounter() >= maxAllocations))
+      status = CppParseStatus::kAllocationBudgetExceeded;
+    return isHit();
+  }
+};
+
+/// Non-null only while parsing is being done under limits.
+extern CppParseLimits* gParseLimits;
+
+inline bool parseShouldStop(bool always = false)
+{
+  return gParseLimits && gParseLimits->check(always);
+}
+
+inline bool isParseStopped()
+{
+  return gParseLimits && gParseLimits->isHit();
+}
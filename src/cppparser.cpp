@@ -23,12 +23,20 @@
 
 #include "cppparser.h"
 #include "cppast.h"
+#include "cppdebuglog.h"
 #include "cppobjfactory.h"
+#include "cppparselimits.h"
+#include "cppprepro.h"
+#include "cpptracer.h"
 #include "string-utils.h"
 #include "utils.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
 #include <map>
+#include <mutex>
 #include <set>
 #include <vector>
 
@@ -39,9 +47,53 @@ std::set<std::string>      gKnownApiDecorNames;
 std::set<std::string>      gIgnorableMacroNames;
 std::map<std::string, int> gRenamedKeywords;
 bool                       gParseEnumBodyAsBlob = false;
+std::vector<std::string>   gSkippedNamespacePatterns;
+std::vector<std::string>   gSkippedClassPatterns;
+CppPreproMacros            gPreproMacros;
+bool                       gSkipInactivePreproBranches     = false;
+bool                       gKeepInactivePreproBranchAsBlob = false;
 
 extern CppCompoundPtr parseStream(char* stm, size_t stmSize);
-CppObjFactory*        gObjFactory = nullptr;
+const CppObjFactory*  gObjFactory  = nullptr;
+CppParserStats*       gParserStats = nullptr; ///< Non-null only while statistics are being collected.
+CppTracer*            gTracer      = nullptr; ///< Non-null only while parsing is being traced.
+CppParseLimits*       gParseLimits = nullptr;
+CppPreproNotes*       gPreproNotes = nullptr; ///< Non-null only while all branches of #if are parsed for configurations.
+
+#if CPPPARSER_DEBUG_LOG
+
+static std::mutex         gLogMutex;
+static CppParser::LogSink gLogSink;
+
+void cppDebugLog(const char* format, ...)
+{
+  char    buf[512];
+  va_list args;
+  va_start(args, format);
+  const auto len = std::vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len < 0)
+    return;
+
+  std::vector<char> longBuf;
+  const char*       msg = buf;
+  if (static_cast<size_t>(len) >= sizeof(buf))
+  {
+    longBuf.resize(len + 1);
+    va_start(args, format);
+    std::vsnprintf(longBuf.data(), longBuf.size(), format, args);
+    va_end(args);
+    msg = longBuf.data();
+  }
+
+  std::lock_guard<std::mutex> lock(gLogMutex);
+  if (gLogSink)
+    gLogSink(msg);
+  else
+    std::fputs(msg, stdout);
+}
+
+#endif // #if CPPPARSER_DEBUG_LOG
 
 CppParser::CppParser(CppObjFactoryPtr objFactory)
   : objFactory_(std::move(objFactory))
@@ -94,25 +146,459 @@ bool CppParser::addRenamedKeyword(const std::string& keyword, std::string rename
   return true;
 }
 
-void CppParser::parseEnumBodyAsBlob()
+void CppParser::parseEnumBodyAsBlob(bool enable)
+{
+  gParseEnumBodyAsBlob = enable;
+}
+
+void CppParser::addSkippedNamespace(std::string pattern)
+{
+  gSkippedNamespacePatterns.push_back(std::move(pattern));
+}
+
+void CppParser::addSkippedClass(std::string pattern)
+{
+  gSkippedClassPatterns.push_back(std::move(pattern));
+}
+
+void CppParser::clearSkippedNamespaces()
+{
+  gSkippedNamespacePatterns.clear();
+}
+
+void CppParser::clearSkippedClasses()
+{
+  gSkippedClassPatterns.clear();
+}
+
+void CppParser::defineMacro(std::string macro, std::string value)
 {
-  gParseEnumBodyAsBlob = true;
+  gPreproMacros.define(std::move(macro), std::move(value));
 }
 
+void CppParser::undefineMacro(std::string macro)
+{
+  gPreproMacros.undefine(std::move(macro));
+}
+
+void CppParser::clearMacros()
+{
+  gPreproMacros.clear();
+}
+
+void CppParser::skipInactivePreproBranches(bool skip, bool keepAsBlob)
+{
+  gSkipInactivePreproBranches     = skip;
+  gKeepInactivePreproBranchAsBlob = skip && keepAsBlob;
+}
+
+void CppParser::debugLog(unsigned logFlags)
+{
+  extern void setDebugLog(unsigned logFlags);
+  setDebugLog(logFlags);
+}
+
+#if CPPPARSER_DEBUG_LOG
+void CppParser::logSink(LogSink sink)
+{
+  std::lock_guard<std::mutex> lock(gLogMutex);
+  gLogSink = std::move(sink);
+}
+#else // #if CPPPARSER_DEBUG_LOG
+void CppParser::logSink(LogSink)
+{
+}
+#endif // #if CPPPARSER_DEBUG_LOG
+
 CppCompoundPtr CppParser::parseFile(const std::string& filename)
 {
-  auto stm         = readFile(filename);
-  auto cppCompound = parseStream(stm.data(), stm.size());
+  if (cancellationToken_ && cancellationToken_->isCancelled())
+  {
+    lastParseStatus_ = CppParseStatus::kCancelled;
+    return nullptr;
+  }
+  std::vector<char> stm;
+  {
+    CppTraceScope traceRead(tracer_, "read", filename);
+    stm = readFile(filename);
+    traceRead.numBytes(stm.size());
+  }
+  auto cppCompound = parseStream(stm.data(), stm.size(), filename);
   if (!cppCompound)
     return cppCompound;
   cppCompound->name(filename);
   return cppCompound;
 }
 
+namespace {
+
+bool isStartOfPreproChain(const CppHashIf* hashIf)
+{
+  return (hashIf->condType_ == CppHashIf::kIf) || (hashIf->condType_ == CppHashIf::kIfDef)
+         || (hashIf->condType_ == CppHashIf::kIfNDef);
+}
+
+/**
+ * Counts #if and alike, #define, and #undef that are members of \a compound or of compounds in it.
+ * @return false if a chain of #if is not wholly inside one compound, e.g. when its branches open a block differently.
+ */
+bool countPreproDirectives(const CppCompound* compound, std::size_t& numDirectives)
+{
+  int condDepth = 0;
+  for (const auto& mem : compound->members())
+  {
+    switch (mem->objType_)
+    {
+      case CppObjType::kHashIf:
+      {
+        ++numDirectives;
+        const auto* hashIf = static_cast<const CppHashIf*>(mem.get());
+        if (isStartOfPreproChain(hashIf))
+          ++condDepth;
+        else if ((hashIf->condType_ == CppHashIf::kEndIf) && (--condDepth < 0))
+          return false;
+        break;
+      }
+      case CppObjType::kHashDefine:
+      case CppObjType::kHashUndef:
+        ++numDirectives;
+        break;
+      case CppObjType::kCompound:
+        if (!countPreproDirectives(static_cast<const CppCompound*>(mem.get()), numDirectives))
+          return false;
+        break;
+      default:
+        break;
+    }
+  }
+  return condDepth == 0;
+}
+
+/**
+ * Finds members of an AST that has all branches of #if which one configuration does not have.
+ * Branches are decided as lexer decides them when it skips inactive ones, see CppParser::skipInactivePreproBranches().
+ */
+class InactiveBranchFinder
+{
+public:
+  InactiveBranchFinder(CppPreproMacros macros)
+    : macros_(std::move(macros))
+    , hiddenMembers_(std::make_shared<CppConfigAst::HiddenMembers>())
+  {
+  }
+
+  /// Members of inactive branches are hidden in document order, which is also the order in which input changes macros.
+  void hideInactiveBranches(const CppCompound* compound)
+  {
+    CppPreproBranches branches; // Chains are known not to cross compounds.
+    bool              inactive        = false;
+    int               inactiveNesting = 0; // Depth of #if nested in inactive branch.
+    for (const auto& mem : compound->members())
+    {
+      const CppObj* obj = mem.get();
+      if (inactive)
+      {
+        if (obj->objType_ != CppObjType::kHashIf)
+        {
+          hiddenMembers_->insert(obj);
+          continue;
+        }
+        const auto* hashIf = static_cast<const CppHashIf*>(obj);
+        if (isStartOfPreproChain(hashIf))
+          ++inactiveNesting;
+        if (inactiveNesting > 0)
+        {
+          if (hashIf->condType_ == CppHashIf::kEndIf)
+            --inactiveNesting;
+          hiddenMembers_->insert(obj);
+          continue;
+        }
+      }
+
+      switch (obj->objType_)
+      {
+        case CppObjType::kHashIf:
+          inactive = isBranchInactive(branches, static_cast<const CppHashIf*>(obj));
+          break;
+        case CppObjType::kHashDefine:
+          macros_.forget(static_cast<const CppDefine*>(obj)->name_);
+          break;
+        case CppObjType::kHashUndef:
+          macros_.forget(static_cast<const CppUndef*>(obj)->name_);
+          break;
+        case CppObjType::kCompound:
+          hideInactiveBranches(static_cast<const CppCompound*>(obj));
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  /// '0' for each branch that is inactive and '1' for each one that is not, same ones mean same hidden members.
+  const std::string& decisions() const
+  {
+    return decisions_;
+  }
+  const std::shared_ptr<CppConfigAst::HiddenMembers>& hiddenMembers() const
+  {
+    return hiddenMembers_;
+  }
+
+private:
+  bool isBranchInactive(CppPreproBranches& branches, const CppHashIf* hashIf)
+  {
+    const auto& cond     = hashIf->cond_;
+    auto        evalCond = [&]() { return evalPreproCondition(cond.data(), cond.data() + cond.size(), macros_); };
+
+    bool inactive = false;
+    switch (hashIf->condType_)
+    {
+      case CppHashIf::kIf:
+        inactive = branches.onIf(evalCond());
+        break;
+      case CppHashIf::kIfDef:
+        inactive = branches.onIf(evalPreproDefined(cond, macros_));
+        break;
+      case CppHashIf::kIfNDef:
+        inactive = branches.onIf(!evalPreproDefined(cond, macros_));
+        break;
+      case CppHashIf::kElIf:
+        inactive = branches.onElse(evalCond);
+        break;
+      case CppHashIf::kElse:
+        inactive = branches.onElse([]() { return CppPreproValue::kTrue; });
+        break;
+      case CppHashIf::kEndIf:
+        branches.onEndIf();
+        return false;
+    }
+    decisions_.push_back(inactive ? '0' : '1');
+    return inactive;
+  }
+
+private:
+  CppPreproMacros                              macros_;
+  std::string                                  decisions_;
+  std::shared_ptr<CppConfigAst::HiddenMembers> hiddenMembers_;
+};
+
+} // namespace
+
+std::vector<CppConfigAst> CppParser::parseFileForConfigs(const std::string&                   filename,
+                                                         const std::vector<MacroDefinitions>& configs)
+{
+  std::vector<CppConfigAst> configAsts(configs.size());
+  std::vector<char>         contents;
+  {
+    CppTraceScope traceRead(tracer_, "read", filename);
+    contents = readFile(filename);
+    traceRead.numBytes(contents.size());
+  }
+  if (contents.empty())
+  {
+    lastParseStatus_ = CppParseStatus::kParseError;
+    return configAsts;
+  }
+
+  std::set<std::string> allMacros;
+  for (const auto& config : configs)
+  {
+    for (const auto& macro : config)
+      allMacros.insert(macro.first);
+  }
+  std::vector<CppPreproMacros> configMacros(configs.size(), gPreproMacros);
+  for (size_t i = 0; i < configs.size(); ++i)
+  {
+    for (const auto& macro : allMacros)
+    {
+      auto itr = configs[i].find(macro);
+      if (itr != configs[i].end())
+        configMacros[i].define(macro, itr->second);
+      else
+        configMacros[i].undefine(macro);
+    }
+  }
+
+  const auto origMacros               = gPreproMacros;
+  const auto origSkipInactiveBranches = gSkipInactivePreproBranches;
+  const auto origKeepAsBlob           = gKeepInactivePreproBranchAsBlob;
+  auto       restoreGlobals           = [&]() {
+    gPreproMacros                   = origMacros;
+    gSkipInactivePreproBranches     = origSkipInactiveBranches;
+    gKeepInactivePreproBranchAsBlob = origKeepAsBlob;
+  };
+
+  // Lexing and parsing leave buffer intact but it is copied anyway so that nothing depends on that.
+  std::vector<char> stm = contents;
+  CppPreproNotes    preproNotes;
+  gSkipInactivePreproBranches = false;
+  gPreproNotes                = &preproNotes;
+  auto fullAst                = parseStream(stm.data(), stm.size(), filename);
+  gPreproNotes                = nullptr;
+  restoreGlobals();
+  // Parsing that hit a limit would hit it again.
+  if (!fullAst && (lastParseStatus_ != CppParseStatus::kParseError))
+    return configAsts;
+
+  // AST that has all branches can be shared when every directive is a member of a compound and nothing in a branch
+  // changes how input after the branch is parsed.
+  std::size_t numDirectives = 0;
+  if (fullAst && !preproNotes.accessChangedInBranch && countPreproDirectives(fullAst.get(), numDirectives)
+      && (numDirectives == preproNotes.numDirectives))
+  {
+    fullAst->name(filename);
+    std::shared_ptr<const CppCompound>  sharedAst = std::move(fullAst);
+    std::map<std::string, CppConfigAst> astOfDecisions;
+    for (size_t i = 0; i < configs.size(); ++i)
+    {
+      InactiveBranchFinder finder(std::move(configMacros[i]));
+      finder.hideInactiveBranches(sharedAst.get());
+      auto itr = astOfDecisions.find(finder.decisions());
+      if (itr == astOfDecisions.end())
+        itr = astOfDecisions.emplace(finder.decisions(), CppConfigAst(sharedAst, finder.hiddenMembers())).first;
+      configAsts[i] = itr->second;
+    }
+    return configAsts;
+  }
+
+  // Otherwise the file is lexed for each configuration to know which branches it takes and it is parsed once for each
+  // distinct choice of branches.
+  extern std::string lexPreproBranchDecisions(char* buf, size_t bufsize);
+
+  gSkipInactivePreproBranches     = true;
+  gKeepInactivePreproBranchAsBlob = false;
+
+  std::map<std::string, CppConfigAst> astOfDecisions;
+  for (size_t i = 0; i < configs.size(); ++i)
+  {
+    gPreproMacros        = configMacros[i];
+    stm                  = contents;
+    const auto decisions = lexPreproBranchDecisions(stm.data(), stm.size());
+    auto       itr       = astOfDecisions.find(decisions);
+    if (itr == astOfDecisions.end())
+    {
+      stm         = contents;
+      auto cppAst = parseStream(stm.data(), stm.size(), filename);
+      if (cppAst)
+        cppAst->name(filename);
+      itr = astOfDecisions.emplace(decisions, CppConfigAst(std::move(cppAst))).first;
+    }
+    configAsts[i] = itr->second;
+  }
+
+  restoreGlobals();
+  return configAsts;
+}
+
 CppCompoundPtr CppParser::parseStream(char* stm, size_t stmSize)
 {
+  return parseStream(stm, stmSize, std::string());
+}
+
+CppCompoundPtr CppParser::parseStream(char* stm, size_t stmSize, const std::string& streamName)
+{
+  lastParseStatus_ = CppParseStatus::kParseError;
   if (stm == nullptr || stmSize == 0)
     return nullptr;
-  gObjFactory = objFactory_.get();
-  return ::parseStream(stm, stmSize);
+  if (cancellationToken_ && cancellationToken_->isCancelled())
+  {
+    lastParseStatus_ = CppParseStatus::kCancelled;
+    return nullptr;
+  }
+
+  CppParseLimits limits;
+  limits.cancellationToken = cancellationToken_;
+  if (timeBudget_ != std::chrono::steady_clock::duration::zero())
+    limits.deadline = std::chrono::steady_clock::now() + timeBudget_;
+  if (allocationBudget_ && allocationCounter_)
+  {
+    limits.allocationCounter = allocationCounter_;
+    limits.maxAllocations    = allocationCounter_() + allocationBudget_;
+  }
+  const bool hasLimits = limits.cancellationToken || (limits.deadline != std::chrono::steady_clock::time_point::max())
+                         || limits.allocationCounter;
+
+  CppTraceScope traceParse(tracer_, "parse", streamName, stmSize);
+  gObjFactory  = objFactory_.get();
+  gTracer      = tracer_;
+  gParseLimits = hasLimits ? &limits : nullptr;
+  auto cppAst  = collectStats_ ? parseStreamCollectingStats(stm, stmSize) : ::parseStream(stm, stmSize);
+  gParseLimits = nullptr;
+  gTracer      = nullptr;
+  gObjFactory  = nullptr;
+
+  // What got parsed before hitting a limit is incomplete and so it is thrown away.
+  if (limits.isHit())
+  {
+    cppAst.reset();
+    lastParseStatus_ = limits.status;
+  }
+  else if (cppAst)
+  {
+    lastParseStatus_ = CppParseStatus::kSuccess;
+  }
+  return cppAst;
+}
+
+CppCompoundPtr CppParser::parseStreamCollectingStats(char* stm, size_t stmSize)
+{
+  CppParserStats parseStats;
+  parseStats.numParses     = 1;
+  parseStats.numBytes      = stmSize;
+  const auto numAllocsOrig = allocationCounter_ ? allocationCounter_() : 0;
+  const auto startTime     = std::chrono::steady_clock::now();
+  gParserStats             = &parseStats;
+  auto cppAst              = ::parseStream(stm, stmSize);
+  gParserStats             = nullptr;
+  const auto totalSeconds  = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  parseStats.parseSeconds  = totalSeconds - parseStats.lexSeconds;
+  if (allocationCounter_)
+    parseStats.numAllocations = allocationCounter_() - numAllocsOrig;
+
+  lastParseStats_ = parseStats;
+  stats_ += parseStats;
+  return cppAst;
+}
+
+/**
+ * Parses \a body of an enum that was kept as blob, see CppEnum::items().
+ * @param objFactory Creates objects of AST, nullptr means CppObjFactory itself.
+ * @return AST whose only member is an enum having items of \a body, nullptr if \a body cannot be parsed.
+ */
+CppCompoundPtr parseEnumBlob(const std::string& body, const CppObjFactory* objFactory)
+{
+  // Serializes calls of CppEnum::items() from many threads, it cannot stop any other parse that is going on.
+  static std::mutex           enumBlobMutex;
+  std::lock_guard<std::mutex> lock(enumBlobMutex);
+
+  static const CppObjFactory defaultObjFactory {};
+
+  std::string       input = "enum CppParserEnumBlob {" + body + "\n};\n";
+  std::vector<char> stm(input.begin(), input.end());
+  stm.push_back('\0');
+  stm.push_back('\0');
+
+  // Parser is not reentrant and so globals that control it are set only for as long as this parse.
+  const auto objFactoryOrig          = gObjFactory;
+  const auto parserStatsOrig         = gParserStats;
+  const auto tracerOrig              = gTracer;
+  const auto parseLimitsOrig         = gParseLimits;
+  const auto preproNotesOrig         = gPreproNotes;
+  const auto parseEnumBodyAsBlobOrig = gParseEnumBodyAsBlob;
+  gObjFactory                        = objFactory ? objFactory : &defaultObjFactory;
+  gParserStats                       = nullptr;
+  gTracer                            = nullptr;
+  gParseLimits                       = nullptr;
+  gPreproNotes                       = nullptr;
+  gParseEnumBodyAsBlob               = false;
+  auto cppAst                        = ::parseStream(stm.data(), stm.size());
+  gObjFactory                        = objFactoryOrig;
+  gParserStats                       = parserStatsOrig;
+  gTracer                            = tracerOrig;
+  gParseLimits                       = parseLimitsOrig;
+  gPreproNotes                       = preproNotesOrig;
+  gParseEnumBodyAsBlob               = parseEnumBodyAsBlobOrig;
+
+  return cppAst;
 }
@@ -0,0 +1,415 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cppprepro.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+CppPreproMacros::State CppPreproMacros::state(const std::string& name, const std::string** value) const
+{
+  auto itr = defined_.find(name);
+  if (itr != defined_.end())
+  {
+    if (value)
+      *value = &itr->second;
+    return kDefined;
+  }
+  return undefined_.count(name) ? kUndefined : kUnknown;
+}
+
+CppPreproValue evalPreproDefined(const std::string& name, const CppPreproMacros& macros)
+{
+  switch (macros.state(name))
+  {
+    case CppPreproMacros::kDefined:
+      return CppPreproValue::kTrue;
+    case CppPreproMacros::kUndefined:
+      return CppPreproValue::kFalse;
+    default:
+      return CppPreproValue::kUnknown;
+  }
+}
+
+namespace {
+
+/// Value of a sub expression, which may be unknown.
+struct Value
+{
+  bool      known;
+  long long num;
+};
+
+const Value kUnknownValue = {false, 0};
+
+Value knownValue(long long num)
+{
+  return {true, num};
+}
+
+/// Recursive descent evaluator of expression of #if in which macros are expanded as they are encountered.
+class PreproExprEvaluator
+{
+public:
+  PreproExprEvaluator(const char* begin, const char* end, const CppPreproMacros& macros, int depth = 0)
+    : p_(begin)
+    , end_(end)
+    , macros_(macros)
+    , depth_(depth)
+  {
+  }
+
+  Value eval()
+  {
+    auto value = evalConditional();
+    skipSpaces();
+    return (failed_ || (p_ != end_)) ? kUnknownValue : value;
+  }
+
+private:
+  // Precedence of binary operators, higher binds tighter.
+  static int precedence(const char* op)
+  {
+    static const struct
+    {
+      const char* op;
+      int         prec;
+    } kOps[] = {{"||", 1}, {"&&", 2}, {"|", 3},  {"^", 4},  {"&", 5},  {"==", 6}, {"!=", 6},
+                {"<=", 7}, {">=", 7}, {"<<", 8}, {">>", 8}, {"<", 7},  {">", 7},  {"+", 9},
+                {"-", 9},  {"*", 10}, {"/", 10}, {"%", 10}};
+    for (const auto& entry : kOps)
+    {
+      if (std::strcmp(entry.op, op) == 0)
+        return entry.prec;
+    }
+    return 0;
+  }
+
+  void skipSpaces()
+  {
+    while (p_ != end_)
+    {
+      if (std::isspace(static_cast<unsigned char>(*p_)) || (*p_ == '\\'))
+      {
+        ++p_;
+      }
+      else if ((*p_ == '/') && (p_ + 1 != end_) && (p_[1] == '/'))
+      {
+        p_ = end_;
+      }
+      else if ((*p_ == '/') && (p_ + 1 != end_) && (p_[1] == '*'))
+      {
+        const char* commentEnd = p_ + 2;
+        while ((commentEnd + 1 < end_) && !((commentEnd[0] == '*') && (commentEnd[1] == '/')))
+          ++commentEnd;
+        p_ = (commentEnd + 1 < end_) ? commentEnd + 2 : end_;
+      }
+      else
+      {
+        break;
+      }
+    }
+  }
+
+  bool consume(char c)
+  {
+    skipSpaces();
+    if ((p_ == end_) || (*p_ != c))
+      return false;
+    ++p_;
+    return true;
+  }
+
+  /// @return Binary operator at current position without consuming it, or empty string.
+  std::string peekBinaryOp()
+  {
+    skipSpaces();
+    if (p_ == end_)
+      return std::string();
+    static const char* const kTwoCharOps[] = {"||", "&&", "==", "!=", "<=", ">=", "<<", ">>"};
+    if (p_ + 1 != end_)
+    {
+      for (const auto* op : kTwoCharOps)
+      {
+        if ((p_[0] == op[0]) && (p_[1] == op[1]))
+          return op;
+      }
+    }
+    if (std::strchr("|^&<>+-*/%", *p_))
+      return std::string(1, *p_);
+    return std::string();
+  }
+
+  Value evalConditional()
+  {
+    auto cond = evalBinary(1);
+    if (!consume('?'))
+      return cond;
+    auto lhs = evalConditional();
+    if (!consume(':'))
+    {
+      failed_ = true;
+      return kUnknownValue;
+    }
+    auto rhs = evalConditional();
+    if (!cond.known)
+      return (lhs.known && rhs.known && (lhs.num == rhs.num)) ? lhs : kUnknownValue;
+    return cond.num ? lhs : rhs;
+  }
+
+  Value evalBinary(int minPrec)
+  {
+    auto lhs = evalUnary();
+    for (auto op = peekBinaryOp(); !failed_ && !op.empty() && (precedence(op.c_str()) >= minPrec); op = peekBinaryOp())
+    {
+      p_ += op.size();
+      auto rhs = evalBinary(precedence(op.c_str()) + 1);
+      lhs      = apply(op, lhs, rhs);
+    }
+    return lhs;
+  }
+
+  static Value apply(const std::string& op, Value lhs, Value rhs)
+  {
+    // Value of one side alone is enough when it short circuits the other.
+    if (op == "&&")
+    {
+      if ((lhs.known && !lhs.num) || (rhs.known && !rhs.num))
+        return knownValue(0);
+      return (lhs.known && rhs.known) ? knownValue(1) : kUnknownValue;
+    }
+    if (op == "||")
+    {
+      if ((lhs.known && lhs.num) || (rhs.known && rhs.num))
+        return knownValue(1);
+      return (lhs.known && rhs.known) ? knownValue(0) : kUnknownValue;
+    }
+    if (!lhs.known || !rhs.known)
+      return kUnknownValue;
+
+    const auto a = lhs.num;
+    const auto b = rhs.num;
+    switch (op[0])
+    {
+      case '|':
+        return knownValue(a | b);
+      case '^':
+        return knownValue(a ^ b);
+      case '&':
+        return knownValue(a & b);
+      case '=':
+        return knownValue(a == b);
+      case '!':
+        return knownValue(a != b);
+      case '+':
+        return knownValue(a + b);
+      case '-':
+        return knownValue(a - b);
+      case '*':
+        return knownValue(a * b);
+      case '/':
+        return b ? knownValue(a / b) : kUnknownValue;
+      case '%':
+        return b ? knownValue(a % b) : kUnknownValue;
+      case '<':
+        if (op == "<<")
+          return ((b >= 0) && (b < 64)) ? knownValue(a << b) : kUnknownValue;
+        return knownValue((op == "<=") ? (a <= b) : (a < b));
+      case '>':
+        if (op == ">>")
+          return ((b >= 0) && (b < 64)) ? knownValue(a >> b) : kUnknownValue;
+        return knownValue((op == ">=") ? (a >= b) : (a > b));
+    }
+    return kUnknownValue;
+  }
+
+  Value evalUnary()
+  {
+    skipSpaces();
+    if (p_ == end_)
+    {
+      failed_ = true;
+      return kUnknownValue;
+    }
+    const char c = *p_;
+    if ((c == '!') || (c == '~') || (c == '-') || (c == '+'))
+    {
+      ++p_;
+      auto value = evalUnary();
+      if (!value.known)
+        return value;
+      switch (c)
+      {
+        case '!':
+          return knownValue(!value.num);
+        case '~':
+          return knownValue(~value.num);
+        case '-':
+          return knownValue(-value.num);
+        default:
+          return value;
+      }
+    }
+    if (c == '(')
+    {
+      ++p_;
+      auto value = evalConditional();
+      if (!consume(')'))
+        failed_ = true;
+      return value;
+    }
+    if (std::isdigit(static_cast<unsigned char>(c)))
+      return evalNumber();
+    if (std::isalpha(static_cast<unsigned char>(c)) || (c == '_'))
+      return evalIdentifier();
+
+    failed_ = true;
+    return kUnknownValue;
+  }
+
+  Value evalNumber()
+  {
+    const char* numEnd = p_;
+    while ((numEnd != end_) && (std::isalnum(static_cast<unsigned char>(*numEnd)) || (*numEnd == '\'')))
+      ++numEnd;
+    std::string digits;
+    for (const char* q = p_; q != numEnd; ++q)
+    {
+      if (*q != '\'')
+        digits += *q;
+    }
+    p_ = numEnd;
+
+    int base = 10;
+    size_t start = 0;
+    if ((digits.size() > 1) && (digits[0] == '0'))
+    {
+      if ((digits[1] == 'x') || (digits[1] == 'X'))
+        base = 16, start = 2;
+      else if ((digits[1] == 'b') || (digits[1] == 'B'))
+        base = 2, start = 2;
+      else
+        base = 8, start = 1;
+    }
+    char*      parsedEnd = nullptr;
+    const auto num       = std::strtoull(digits.c_str() + start, &parsedEnd, base);
+    // Only integer suffixes are allowed after digits.
+    for (; *parsedEnd; ++parsedEnd)
+    {
+      if (!std::strchr("uUlL", *parsedEnd))
+        return kUnknownValue;
+    }
+    return knownValue(static_cast<long long>(num));
+  }
+
+  Value evalIdentifier()
+  {
+    const char* idEnd = p_;
+    while ((idEnd != end_) && (std::isalnum(static_cast<unsigned char>(*idEnd)) || (*idEnd == '_')))
+      ++idEnd;
+    const std::string name(p_, idEnd);
+    p_ = idEnd;
+
+    if (name == "defined")
+    {
+      const bool inBrackets = consume('(');
+      skipSpaces();
+      const char* nameEnd = p_;
+      while ((nameEnd != end_) && (std::isalnum(static_cast<unsigned char>(*nameEnd)) || (*nameEnd == '_')))
+        ++nameEnd;
+      if (nameEnd == p_)
+      {
+        failed_ = true;
+        return kUnknownValue;
+      }
+      const std::string macro(p_, nameEnd);
+      p_ = nameEnd;
+      if (inBrackets && !consume(')'))
+      {
+        failed_ = true;
+        return kUnknownValue;
+      }
+      const auto value = evalPreproDefined(macro, macros_);
+      return (value == CppPreproValue::kUnknown) ? kUnknownValue : knownValue(value == CppPreproValue::kTrue);
+    }
+    if (name == "true")
+      return knownValue(1);
+    if (name == "false")
+      return knownValue(0);
+
+    // Function like macros and things like __has_include() are not evaluated.
+    skipSpaces();
+    if ((p_ != end_) && (*p_ == '('))
+    {
+      int numOpenBrackets = 0;
+      for (; p_ != end_; ++p_)
+      {
+        if (*p_ == '(')
+          ++numOpenBrackets;
+        else if ((*p_ == ')') && (--numOpenBrackets == 0))
+          break;
+      }
+      if (p_ == end_)
+        failed_ = true;
+      else
+        ++p_;
+      return kUnknownValue;
+    }
+
+    const std::string* defn = nullptr;
+    switch (macros_.state(name, &defn))
+    {
+      case CppPreproMacros::kUndefined:
+        return knownValue(0);
+      case CppPreproMacros::kDefined:
+      {
+        // Guards against macros that are defined in terms of each other.
+        static const int kMaxExpansionDepth = 16;
+        if (defn->empty() || (depth_ >= kMaxExpansionDepth))
+          return kUnknownValue;
+        return PreproExprEvaluator(defn->data(), defn->data() + defn->size(), macros_, depth_ + 1).eval();
+      }
+      default:
+        return kUnknownValue;
+    }
+  }
+
+private:
+  const char*            p_;
+  const char*            end_;
+  const CppPreproMacros& macros_;
+  const int              depth_;
+  bool                   failed_ = false;
+};
+
+} // namespace
+
+CppPreproValue evalPreproCondition(const char* begin, const char* end, const CppPreproMacros& macros)
+{
+  const auto value = PreproExprEvaluator(begin, end, macros).eval();
+  if (!value.known)
+    return CppPreproValue::kUnknown;
+  return value.num ? CppPreproValue::kTrue : CppPreproValue::kFalse;
+}
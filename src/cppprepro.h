@@ -0,0 +1,186 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Macros known to be defined or known to be undefined.
+ * Nothing is assumed about other macros, e.g. they can be defined by a header that is not parsed.
+ */
+class CppPreproMacros
+{
+public:
+  enum State
+  {
+    kUnknown,
+    kUndefined,
+    kDefined
+  };
+
+public:
+  void define(std::string name, std::string value);
+  void undefine(std::string name);
+  /// Makes state of macro unknown, e.g. when input itself defines or undefines it.
+  void forget(const std::string& name);
+  /// Makes state of every macro unknown.
+  void clear();
+
+  /// @param value Receives definition of macro when it is defined.
+  State state(const std::string& name, const std::string** value = nullptr) const;
+  bool  empty() const;
+
+private:
+  std::map<std::string, std::string> defined_;
+  std::set<std::string>              undefined_;
+};
+
+enum class CppPreproValue
+{
+  kFalse,
+  kTrue,
+  kUnknown ///< Condition uses something whose value is not known.
+};
+
+/// Evaluates condition of #if or #elif, i.e. the text in [\a begin, \a end).
+CppPreproValue evalPreproCondition(const char* begin, const char* end, const CppPreproMacros& macros);
+/// Evaluates condition of #ifdef.
+CppPreproValue evalPreproDefined(const std::string& name, const CppPreproMacros& macros);
+
+inline CppPreproValue operator!(CppPreproValue value)
+{
+  switch (value)
+  {
+    case CppPreproValue::kFalse:
+      return CppPreproValue::kTrue;
+    case CppPreproValue::kTrue:
+      return CppPreproValue::kFalse;
+    default:
+      return CppPreproValue::kUnknown;
+  }
+}
+
+inline void CppPreproMacros::define(std::string name, std::string value)
+{
+  undefined_.erase(name);
+  defined_[std::move(name)] = std::move(value);
+}
+
+inline void CppPreproMacros::undefine(std::string name)
+{
+  defined_.erase(name);
+  undefined_.insert(std::move(name));
+}
+
+inline void CppPreproMacros::forget(const std::string& name)
+{
+  defined_.erase(name);
+  undefined_.erase(name);
+}
+
+inline void CppPreproMacros::clear()
+{
+  defined_.clear();
+  undefined_.clear();
+}
+
+inline bool CppPreproMacros::empty() const
+{
+  return defined_.empty() && undefined_.empty();
+}
+
+/**
+ * \brief Decides which branches of chains of #if, #elif, and #else are inactive, one directive at a time in order of input.
+ * Directives inside an inactive branch must not be passed as they do not belong to any chain that is being decided.
+ */
+class CppPreproBranches
+{
+public:
+  /// Called for #if, #ifdef, and #ifndef, @return true if branch that follows is inactive.
+  bool onIf(CppPreproValue value);
+  /**
+   * Called for #elif and #else, \a evalCond is called only if chain depends on its value.
+   * @return true if branch that follows is inactive.
+   */
+  template <typename EvalCond>
+  bool onElse(EvalCond evalCond);
+  void onEndIf();
+  void clear();
+
+private:
+  // State of a chain of #if, #elif, #else, and #endif.
+  struct State
+  {
+    bool known;       // False once a condition of the chain cannot be evaluated, then all remaining branches are active.
+    bool branchTaken; // An earlier branch of the chain is active and so remaining ones are not.
+  };
+
+  std::vector<State> chains_;
+};
+
+inline bool CppPreproBranches::onIf(CppPreproValue value)
+{
+  chains_.push_back({value != CppPreproValue::kUnknown, value == CppPreproValue::kTrue});
+  return value == CppPreproValue::kFalse;
+}
+
+template <typename EvalCond>
+bool CppPreproBranches::onElse(EvalCond evalCond)
+{
+  if (chains_.empty() || !chains_.back().known)
+    return false;
+  auto& state = chains_.back();
+  if (state.branchTaken)
+    return true;
+  const CppPreproValue value = evalCond();
+  state.known                = (value != CppPreproValue::kUnknown);
+  state.branchTaken          = (value == CppPreproValue::kTrue);
+  return value == CppPreproValue::kFalse;
+}
+
+inline void CppPreproBranches::onEndIf()
+{
+  if (!chains_.empty())
+    chains_.pop_back();
+}
+
+inline void CppPreproBranches::clear()
+{
+  chains_.clear();
+}
+
+/// What parser notes about directives while all branches of #if are parsed, see CppParser::parseFileForConfigs().
+struct CppPreproNotes
+{
+  /// Number of #if, #ifdef, #ifndef, #elif, #else, #endif, #define, and #undef.
+  std::size_t numDirectives = 0;
+  /// Depth of nesting of #if at the current point of input.
+  int condDepth = 0;
+  /// A label like "public:" is in a branch of #if and so it can change what follows the branch.
+  bool accessChangedInBranch = false;
+};
@@ -22,6 +22,8 @@
  */
 
 #include "cppprog.h"
+#include "cppparallel.h"
+#include "cpptracer.h"
 #include "cpputil.h"
 #include "utils.h"
 
@@ -30,22 +32,37 @@
 #include "cppobj-accessor.h"
 #include "cppvar-accessor.h"
 
+#include <boost/filesystem.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <algorithm>
 #include <iostream>
+#include <mutex>
+#include <unordered_set>
+
+namespace fs = boost::filesystem;
 
 //////////////////////////////////////////////////////////////////////////
 
 CppProgram::CppProgram(const std::vector<std::string>& files, CppParser parser)
   : parser_(std::move(parser))
 {
-  cppObjToTypeNode_[nullptr] = &cppTypeTreeRoot_;
+  cppObjToTypeNode_[shardOf(nullptr)][nullptr] = &cppTypeTreeRoot_;
 
+  CppCompoundArray cppAsts;
   for (const auto& f : files)
   {
     std::cout << "INFO\t Parsing '" << f << "'\n";
-    auto cppAst = parser_.parseFile(f.c_str());
+    FileState fileState;
+    auto      cppAst = parseFile(f, fileState);
     if (cppAst)
-      addCppAst(std::move(cppAst));
+    {
+      fileStates_[cppAst.get()] = fileState;
+      recordParseStats(cppAst.get());
+      cppAsts.emplace_back(std::move(cppAst));
+    }
   }
+  addCppAsts(std::move(cppAsts));
 }
 
 CppProgram::CppProgram(const std::string& folder, CppParser parser, const CppProgFileSelecter& fileSelector)
@@ -55,97 +72,563 @@ CppProgram::CppProgram(const std::string& folder, CppParser parser, const CppPro
 
 void CppProgram::addCppAst(CppCompoundPtr cppAst)
 {
-  if (!isCppFile(cppAst.get()))
+  CppCompoundArray cppAsts;
+  cppAsts.emplace_back(std::move(cppAst));
+  addCppAsts(std::move(cppAsts), 1);
+}
+
+void CppProgram::addCppAsts(CppCompoundArray cppAsts, unsigned numThreads)
+{
+  cppAsts.erase(std::remove_if(cppAsts.begin(),
+                               cppAsts.end(),
+                               [](const CppCompoundPtr& cppAst) { return !isCppFile(cppAst.get()); }),
+                cppAsts.end());
+  if (cppAsts.empty())
+    return;
+
+  std::vector<const CppCompound*> fileAsts;
+  for (const auto& cppAst : cppAsts)
+    fileAsts.push_back(cppAst.get());
+  loadFileTypes(fileAsts, numThreads);
+  for (auto& cppAst : cppAsts)
+    fileAsts_.emplace_back(std::move(cppAst));
+
+  invalidateTypeLookups(fileAsts);
+  indexFiles(fileAsts);
+}
+
+void CppProgram::loadFileTypes(const std::vector<const CppCompound*>& fileAsts, unsigned numThreads)
+{
+  std::vector<FileTypeTree> fileTypeTrees(fileAsts.size());
+  runInParallel(fileAsts.size(), numThreads, [&](size_t i) {
+    CppTraceScope traceLoad(parser_.tracer(), "loadType", fileAsts[i]->name());
+    loadType(fileAsts[i], &fileTypeTrees[i].root, fileTypeTrees[i].storage);
+  });
+
+  // Merging in the order of files keeps the result same as that of loading files one after another.
+  // Only merging of trees is serial, maps of objects are filled in parallel by addTypeTreeStorages().
+  std::vector<TypeTreeStorage*> storages;
+  for (auto& fileTypeTree : fileTypeTrees)
+  {
+    mergeTypeNode(fileTypeTree.root, &cppTypeTreeRoot_, fileTypeTree.storage.relocatedNodes);
+    storages.push_back(&fileTypeTree.storage);
+  }
+  addTypeTreeStorages(storages, fileAsts, numThreads);
+}
+
+void CppProgram::mergeTypeNode(CppTypeTreeNode& from, CppTypeTreeNode* into, CppTypeNodeRelocationMap& relocatedNodes)
+{
+  relocatedNodes[&from] = into;
+  into->cppObjSet.insert(from.cppObjSet.begin(), from.cppObjSet.end());
+  for (auto& child : from.children)
+  {
+    auto itr = into->children.find(child.first);
+    if (itr == into->children.end())
+    {
+      // Whole subtree is moved, only the top node gets new address and so only its children need a fix.
+      auto& movedNode  = into->children.emplace(child.first, std::move(child.second)).first->second;
+      movedNode.parent = into;
+      for (auto& grandChild : movedNode.children)
+        grandChild.second.parent = &movedNode;
+      relocatedNodes[&child.second] = &movedNode;
+    }
+    else
+    {
+      mergeTypeNode(child.second, &itr->second, relocatedNodes);
+    }
+  }
+}
+
+void CppProgram::addTypeTreeStorages(const std::vector<TypeTreeStorage*>&    storages,
+                                     const std::vector<const CppCompound*>& fileAsts,
+                                     unsigned                               numThreads)
+{
+  struct TypeNodeObj
+  {
+    CppTypeTreeNode* typeNode;
+    const CppObj*    obj;
+    size_t           loadOrder;
+  };
+  using ObjAndTypeNode       = std::pair<const CppObj*, CppTypeTreeNode*>;
+  using ObjAndTypeNodeShards = std::array<std::vector<ObjAndTypeNode>, kNumShards>;
+  using TypeNodeObjShards    = std::array<std::vector<TypeNodeObj>, kNumShards>;
+
+  // Maps keyed by file are only looked up here so that storage of each file can be handled by a separate thread.
+  std::vector<std::vector<const CppObj*>*> fileTypeObjs;
+  for (const auto* fileAst : fileAsts)
+    fileTypeObjs.push_back(fileAst ? &fileTypeObjs_[fileAst] : nullptr);
+  std::vector<size_t> firstLoadOrders;
+  for (const auto* storage : storages)
+  {
+    firstLoadOrders.push_back(numLoadedTypeObjs_);
+    numLoadedTypeObjs_ += storage->objToTypeNode.size();
+  }
+
+  // Objects of each storage are first moved to nodes of program and distributed among shards.
+  std::vector<ObjAndTypeNodeShards> objShards(storages.size());
+  std::vector<TypeNodeObjShards>    typeNodeShards(storages.size());
+  runInParallel(storages.size(), numThreads, [&](size_t i) {
+    const auto& relocatedNodes = storages[i]->relocatedNodes;
+    auto        loadOrder      = firstLoadOrders[i];
+    for (const auto& objToTypeNode : storages[i]->objToTypeNode)
+    {
+      auto  itr      = relocatedNodes.find(objToTypeNode.second);
+      auto* typeNode = (itr == relocatedNodes.end()) ? objToTypeNode.second : itr->second;
+      objShards[i][shardOf(objToTypeNode.first)].emplace_back(objToTypeNode.first, typeNode);
+      typeNodeShards[i][shardOf(typeNode)].push_back(TypeNodeObj{typeNode, objToTypeNode.first, loadOrder++});
+      if (fileTypeObjs[i])
+        fileTypeObjs[i]->push_back(objToTypeNode.first);
+    }
+  });
+
+  // Then each shard is filled by one thread.
+  runInParallel(kNumShards, numThreads, [&](size_t shard) {
+    for (size_t i = 0; i < storages.size(); ++i)
+    {
+      for (const auto& objAndTypeNode : objShards[i][shard])
+        cppObjToTypeNode_[shard][objAndTypeNode.first] = objAndTypeNode.second;
+      for (const auto& typeNodeObj : typeNodeShards[i][shard])
+        typeNodeObjs_[shard][typeNodeObj.typeNode].emplace(typeNodeObj.obj, typeNodeObj.loadOrder);
+    }
+  });
+}
+
+void CppProgram::unloadFileTypes(const CppCompound* fileAst)
+{
+  auto fileTypeObjsItr = fileTypeObjs_.find(fileAst);
+  if (fileTypeObjsItr == fileTypeObjs_.end())
     return;
-  loadType(cppAst.get(), &cppTypeTreeRoot_);
-  fileAsts_.emplace_back(std::move(cppAst));
+
+  std::unordered_set<CppTypeTreeNode*> affectedNodes;
+  for (const auto* cppObj : fileTypeObjsItr->second)
+  {
+    auto& objToTypeNode = cppObjToTypeNode_[shardOf(cppObj)];
+    auto  nodeItr       = objToTypeNode.find(cppObj);
+    if (nodeItr == objToTypeNode.end())
+      continue;
+    auto* typeNode = nodeItr->second;
+    objToTypeNode.erase(nodeItr);
+    auto& nodeObjs = typeNodeObjs_[shardOf(typeNode)][typeNode];
+    nodeObjs.erase(cppObj);
+    // cppObjSet keeps the first loaded object of each type and so next one of same type may need to take its place.
+    // Only that object is looked for among all objects of the node, removal of any other object is just a hash lookup.
+    auto setItr = typeNode->cppObjSet.find(cppObj);
+    if ((setItr != typeNode->cppObjSet.end()) && (*setItr == cppObj))
+    {
+      typeNode->cppObjSet.erase(setItr);
+      const std::pair<const CppObj* const, size_t>* firstLoaded = nullptr;
+      for (const auto& nodeObj : nodeObjs)
+      {
+        if ((nodeObj.first->objType_ == cppObj->objType_) && (!firstLoaded || (nodeObj.second < firstLoaded->second)))
+          firstLoaded = &nodeObj;
+      }
+      if (firstLoaded)
+        typeNode->cppObjSet.insert(firstLoaded->first);
+    }
+    affectedNodes.insert(typeNode);
+  }
+  fileTypeObjs_.erase(fileTypeObjsItr);
+
+  // Every node that becomes empty is among affected nodes, so removing the deeper ones first never leaves a
+  // dangling node to visit.
+  std::vector<std::pair<size_t, CppTypeTreeNode*>> nodesByDepth;
+  for (auto* typeNode : affectedNodes)
+  {
+    size_t depth = 0;
+    for (auto* node = typeNode; node->parent; node = node->parent)
+      ++depth;
+    nodesByDepth.emplace_back(depth, typeNode);
+  }
+  std::sort(nodesByDepth.begin(), nodesByDepth.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.first > rhs.first;
+  });
+  for (const auto& depthAndNode : nodesByDepth)
+  {
+    auto* typeNode = depthAndNode.second;
+    if (!typeNode->parent || !typeNode->cppObjSet.empty() || !typeNode->children.empty())
+      continue;
+    typeNodeObjs_[shardOf(typeNode)].erase(typeNode);
+    // Key of a node is a view of its name, so the name must not go away before the lookup is done.
+    auto& siblings = typeNode->parent->children;
+    auto  itr      = siblings.find(boost::string_view(*typeNode->name));
+    if (itr != siblings.end())
+      siblings.erase(itr);
+  }
+}
+
+CppTypeTreeNode& CppProgram::addTypeNode(const CppObj*       cppObj,
+                                         const std::string& name,
+                                         CppTypeTreeNode*   parentTypeNode,
+                                         TypeTreeStorage&   storage)
+{
+  auto itr = parentTypeNode->children.find(name);
+  if (itr == parentTypeNode->children.end())
+  {
+    std::unique_ptr<const std::string> nodeName(new std::string(name));
+    const boost::string_view           key(*nodeName);
+    itr              = parentTypeNode->children.emplace(key, CppTypeTreeNode()).first;
+    itr->second.name = std::move(nodeName);
+  }
+  auto& childNode = itr->second;
+  childNode.cppObjSet.insert(cppObj);
+  childNode.parent = parentTypeNode;
+  storage.objToTypeNode.emplace_back(cppObj, &childNode);
+  return childNode;
 }
 
 void CppProgram::addCompound(const CppCompound* compound, CppTypeTreeNode* parentTypeNode)
+{
+  clearTypeLookupCache();
+  TypeTreeStorage storage;
+  loadCompound(compound, parentTypeNode, storage);
+  addTypeTreeStorages({&storage}, {nullptr}, 1);
+}
+
+std::vector<char> CppProgram::readFile(const std::string& file, FileState& fileState) const
+{
+  CppTraceScope             traceRead(parser_.tracer(), "read", file);
+  boost::system::error_code ec;
+  fileState.modifiedTime = fs::last_write_time(file, ec);
+  auto stm               = ::readFile(file);
+  fileState.contentHash  = boost::hash_range(stm.begin(), stm.end());
+  traceRead.numBytes(stm.size());
+  return stm;
+}
+
+CppCompoundPtr CppProgram::parseFile(const std::string& file, FileState& fileState)
+{
+  auto stm    = readFile(file, fileState);
+  auto cppAst = parser_.parseStream(stm.data(), stm.size(), file);
+  if (cppAst)
+    cppAst->name(file);
+  return cppAst;
+}
+
+CppCompoundArray::iterator CppProgram::findFileAst(const std::string& file)
+{
+  return std::find_if(
+    fileAsts_.begin(), fileAsts_.end(), [&file](const CppCompoundPtr& fileAst) { return fileAst->name() == file; });
+}
+
+size_t CppProgram::refresh()
+{
+  std::vector<std::string> changedFiles;
+  for (const auto& fileState : fileStates_)
+  {
+    const auto&               file = fileState.first->name();
+    boost::system::error_code ec;
+    const auto                modifiedTime = fs::last_write_time(file, ec);
+    if (ec || (modifiedTime != fileState.second.modifiedTime))
+      changedFiles.push_back(file);
+  }
+
+  size_t numRefreshed = 0;
+  for (const auto& file : changedFiles)
+  {
+    boost::system::error_code ec;
+    if (fs::exists(file, ec) ? updateFile(file) : removeFile(file))
+      ++numRefreshed;
+  }
+  return numRefreshed;
+}
+
+bool CppProgram::updateFile(const std::string& file)
+{
+  FileState  fileState;
+  auto       stm          = readFile(file, fileState);
+  auto       fileItr      = findFileAst(file);
+  const auto isKnownFile  = (fileItr != fileAsts_.end());
+  auto       fileStateItr = isKnownFile ? fileStates_.find(fileItr->get()) : fileStates_.end();
+  if (fileStateItr != fileStates_.end())
+  {
+    const auto unchanged = (fileStateItr->second.contentHash == fileState.contentHash);
+    // Remembering new modification time saves refresh() from reading a touched but unchanged file again.
+    fileStateItr->second.modifiedTime = fileState.modifiedTime;
+    if (unchanged)
+      return false;
+  }
+
+  auto cppAst = parser_.parseStream(stm.data(), stm.size(), file);
+  if (!cppAst)
+  {
+    // Previous AST of the file is kept if the new content cannot be parsed.
+    if (fileStateItr != fileStates_.end())
+      fileStateItr->second = fileState;
+    return false;
+  }
+  cppAst->name(file);
+
+  if (!isKnownFile)
+  {
+    fileStates_[cppAst.get()] = fileState;
+    recordParseStats(cppAst.get());
+    addCppAst(std::move(cppAst));
+    return true;
+  }
+
+  // Cached lookups can refer to nodes of the file and so they are invalidated before the nodes go away.
+  invalidateTypeLookups({fileItr->get()});
+  unloadFileTypes(fileItr->get());
+  unindexFile(fileItr->get());
+  fileStates_.erase(fileItr->get());
+  fileParseStats_.erase(fileItr->get());
+  fileStates_[cppAst.get()] = fileState;
+  *fileItr                  = std::move(cppAst);
+  recordParseStats(fileItr->get());
+  loadFileTypes({fileItr->get()}, 1);
+  invalidateTypeLookups({fileItr->get()});
+  indexFiles({fileItr->get()});
+  return true;
+}
+
+void CppProgram::recordParseStats(const CppCompound* fileAst)
+{
+  if (parser_.isCollectingStats())
+    fileParseStats_[fileAst] = parser_.lastParseStats();
+}
+
+CppParserStats CppProgram::parseStats() const
+{
+  CppParserStats programStats;
+  for (const auto& fileStats : fileParseStats_)
+    programStats += fileStats.second;
+  return programStats;
+}
+
+const CppParserStats* CppProgram::parseStats(const CppCompound* fileAst) const
+{
+  auto itr = fileParseStats_.find(fileAst);
+  return (itr == fileParseStats_.end()) ? nullptr : &itr->second;
+}
+
+bool CppProgram::removeFile(const std::string& file)
+{
+  auto fileItr = findFileAst(file);
+  if (fileItr == fileAsts_.end())
+    return false;
+  invalidateTypeLookups({fileItr->get()});
+  unloadFileTypes(fileItr->get());
+  unindexFile(fileItr->get());
+  fileStates_.erase(fileItr->get());
+  fileParseStats_.erase(fileItr->get());
+  fileAsts_.erase(fileItr);
+  return true;
+}
+
+void CppProgram::loadCompound(const CppCompound* compound, CppTypeTreeNode* parentTypeNode, TypeTreeStorage& storage)
 {
   if (compound->name().empty())
     return;
-  auto& childNode = parentTypeNode->children[compound->name()];
-  childNode.cppObjSet.insert(compound);
-  childNode.parent            = parentTypeNode;
-  cppObjToTypeNode_[compound] = &childNode;
-  loadType(compound, &childNode);
+  auto& childNode = addTypeNode(compound, compound->name(), parentTypeNode, storage);
+  loadType(compound, &childNode, storage);
 }
 
 void CppProgram::addCompound(const CppCompound* compound, const CppCompound* parent)
 {
-  auto itr = cppObjToTypeNode_.find(parent);
-  if (itr != cppObjToTypeNode_.end())
+  auto& objToTypeNode = cppObjToTypeNode_[shardOf(parent)];
+  auto  itr           = objToTypeNode.find(parent);
+  if (itr != objToTypeNode.end())
     addCompound(compound, itr->second);
 }
 
-void CppProgram::loadType(const CppCompound* cppCompound, CppTypeTreeNode* typeNode)
+void CppProgram::loadType(const CppCompound* cppCompound, CppTypeTreeNode* typeNode, TypeTreeStorage& storage)
 {
   if (cppCompound == NULL)
     return;
   if (isCppFile(cppCompound)) // Type node for file object should be the root itself.
   {
-    cppObjToTypeNode_[cppCompound] = typeNode;
+    storage.objToTypeNode.emplace_back(cppCompound, typeNode);
     typeNode->cppObjSet.insert(cppCompound);
   }
   forEachMember(cppCompound, [&](const CppObj* mem) {
     if (isCompound(mem))
     {
-      addCompound((CppCompound*) mem, typeNode);
+      loadCompound((CppCompound*) mem, typeNode, storage);
     }
     else if (isEnum(mem))
     {
-      CppTypeTreeNode& childNode = typeNode->children[((CppEnum*) mem)->name_];
-      childNode.cppObjSet.insert(mem);
-      childNode.parent       = typeNode;
-      cppObjToTypeNode_[mem] = &childNode;
+      addTypeNode(mem, ((CppEnum*) mem)->name_, typeNode, storage);
     }
     else if (isTypedefName(mem))
     {
-      auto*            typedefName = static_cast<const CppTypedefName*>(mem);
-      CppTypeTreeNode& childNode   = typeNode->children[typedefName->var_->name()];
-      childNode.cppObjSet.insert(mem);
-      childNode.parent       = typeNode;
-      cppObjToTypeNode_[mem] = &childNode;
+      auto* typedefName = static_cast<const CppTypedefName*>(mem);
+      addTypeNode(mem, typedefName->var_->name(), typeNode, storage);
     }
     else if (isUsingDecl(mem))
     {
-      auto*            usingDecl = static_cast<const CppUsingDecl*>(mem);
-      CppTypeTreeNode& childNode = typeNode->children[usingDecl->name_];
-      childNode.cppObjSet.insert(mem);
-      childNode.parent       = typeNode;
-      cppObjToTypeNode_[mem] = &childNode;
+      auto* usingDecl = static_cast<const CppUsingDecl*>(mem);
+      addTypeNode(mem, usingDecl->name_, typeNode, storage);
     }
     else if (isFunctionPtr(mem))
     {
-      CppTypeTreeNode& childNode = typeNode->children[((CppFunctionPointer*) mem)->name_];
-      childNode.cppObjSet.insert(mem);
-      childNode.parent       = typeNode;
-      cppObjToTypeNode_[mem] = &childNode;
+      addTypeNode(mem, ((CppFunctionPointer*) mem)->name_, typeNode, storage);
     }
     else if (isFwdClsDecl(mem))
     {
       auto* fwdCls = static_cast<const CppFwdClsDecl*>(mem);
       if (!(fwdCls->attr() & kFriend))
+        addTypeNode(mem, fwdCls->name_, typeNode, storage);
+    }
+
+    return false;
+  });
+}
+
+const CppTypeTreeNode* CppProgram::findTypeNode(boost::string_view name, const CppTypeTreeNode* typeNode) const
+{
+  const CppTypeLookupKey key(typeNode, name);
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(typeLookupCacheMutex_);
+    auto                                      itr = typeLookupCache_.find(key);
+    if (itr != typeLookupCache_.end())
+      return itr->second;
+  }
+
+  auto* result = findTypeNodeNoCache(name, typeNode);
+
+  std::unique_lock<std::shared_timed_mutex> lock(typeLookupCacheMutex_);
+  if (typeLookupCache_.count(key) != 0)
+    return result;
+  // Emptying a full cache keeps it bounded without keeping track of use of each entry.
+  if ((typeLookupCache_.size() >= kMaxTypeLookups) || (typeLookupCacheNames_.size() >= kMaxTypeLookups))
+  {
+    typeLookupCache_.clear();
+    typeLookupCacheNames_.clear();
+  }
+  // An unqualified name that is found is same as name of the found node, which lives at least as long as the entry
+  // because entries are invalidated before nodes go away. So, only other names need a copy.
+  if (result && result->name && (*result->name == name))
+  {
+    typeLookupCache_.emplace(CppTypeLookupKey(typeNode, *result->name), result);
+  }
+  else
+  {
+    typeLookupCacheNames_.emplace_back(name.data(), name.size());
+    typeLookupCache_.emplace(CppTypeLookupKey(typeNode, typeLookupCacheNames_.back()), result);
+  }
+  return result;
+}
+
+void CppProgram::invalidateTypeLookups(const std::vector<const CppCompound*>& fileAsts)
+{
+  std::unique_lock<std::shared_timed_mutex> lock(typeLookupCacheMutex_);
+  if (typeLookupCache_.empty())
+    return;
+
+  // Only nodes that have no object of other files can go away together with the files.
+  std::unordered_set<std::string>                    typeNames;
+  std::unordered_map<const CppTypeTreeNode*, size_t> numFileObjs;
+  for (const auto* fileAst : fileAsts)
+  {
+    auto itr = fileTypeObjs_.find(fileAst);
+    if (itr == fileTypeObjs_.end())
+      continue;
+    for (const auto* cppObj : itr->second)
+    {
+      const auto* typeNode = typeTreeNodeFromCppObj(cppObj);
+      if (typeNode && typeNode->name)
       {
-        CppTypeTreeNode& childNode = typeNode->children[((CppFwdClsDecl*) mem)->name_];
-        childNode.cppObjSet.insert(mem);
-        childNode.parent       = typeNode;
-        cppObjToTypeNode_[mem] = &childNode;
+        typeNames.insert(*typeNode->name);
+        ++numFileObjs[typeNode];
       }
     }
+  }
+  std::unordered_set<const CppTypeTreeNode*> fileOnlyNodes;
+  for (const auto& typeNodeAndNumObjs : numFileObjs)
+  {
+    const auto& nodeObjs = typeNodeObjs_[shardOf(typeNodeAndNumObjs.first)];
+    auto        itr      = nodeObjs.find(typeNodeAndNumObjs.first);
+    if ((itr == nodeObjs.end()) || (itr->second.size() <= typeNodeAndNumObjs.second))
+      fileOnlyNodes.insert(typeNodeAndNumObjs.first);
+  }
 
+  // A lookup only finds children by components of the name and so its result can change only if a node having the
+  // name of one of the components gets added or removed.
+  auto isAffected = [&](const CppTypeLookupCache::value_type& lookup) {
+    if (fileOnlyNodes.count(lookup.first.first) || fileOnlyNodes.count(lookup.second))
+      return true;
+    const auto name = lookup.first.second;
+    for (size_t begPos = 0; begPos <= name.size();)
+    {
+      auto endPos = name.find("::", begPos);
+      if (endPos == boost::string_view::npos)
+        endPos = name.size();
+      if (typeNames.count(name.substr(begPos, endPos - begPos).to_string()))
+        return true;
+      begPos = endPos + 2;
+    }
     return false;
-  });
+  };
+  for (auto itr = typeLookupCache_.begin(); itr != typeLookupCache_.end();)
+  {
+    if (isAffected(*itr))
+      itr = typeLookupCache_.erase(itr);
+    else
+      ++itr;
+  }
+}
+
+void CppProgram::clearTypeLookupCache()
+{
+  std::unique_lock<std::shared_timed_mutex> lock(typeLookupCacheMutex_);
+  typeLookupCache_.clear();
+  typeLookupCacheNames_.clear();
+}
+
+void CppProgram::indexFiles(const std::vector<const CppCompound*>& fileAsts)
+{
+  {
+    std::lock_guard<std::mutex> lock(symbolIndexMutex_);
+    if (symbolIndex_)
+      symbolIndex_->addFiles(fileAsts);
+  }
+  std::lock_guard<std::mutex> lock(includeGraphMutex_);
+  if (includeGraph_)
+    includeGraph_->addFiles(fileAsts);
+}
+
+void CppProgram::unindexFile(const CppCompound* fileAst)
+{
+  {
+    std::lock_guard<std::mutex> lock(symbolIndexMutex_);
+    if (symbolIndex_)
+      symbolIndex_->removeFile(fileAst);
+  }
+  std::lock_guard<std::mutex> lock(includeGraphMutex_);
+  if (includeGraph_)
+    includeGraph_->removeFile(fileAst);
+}
+
+const CppSymbolIndex& CppProgram::symbolIndex() const
+{
+  std::lock_guard<std::mutex> lock(symbolIndexMutex_);
+  if (!symbolIndex_)
+    symbolIndex_.reset(new CppSymbolIndex(fileAsts_));
+  return *symbolIndex_;
+}
+
+const CppIncludeGraph& CppProgram::includeGraph() const
+{
+  std::lock_guard<std::mutex> lock(includeGraphMutex_);
+  if (!includeGraph_)
+    includeGraph_.reset(new CppIncludeGraph(fileAsts_, includeRoots_));
+  return *includeGraph_;
+}
+
+void CppProgram::includeRoots(std::vector<std::string> roots)
+{
+  includeRoots_ = std::move(roots);
+  std::lock_guard<std::mutex> lock(includeGraphMutex_);
+  includeGraph_.reset();
 }
 
-const CppTypeTreeNode* CppProgram::findTypeNode(const std::string& name, const CppTypeTreeNode* typeNode) const
+const CppTypeTreeNode* CppProgram::findTypeNodeNoCache(boost::string_view     name,
+                                                       const CppTypeTreeNode* typeNode) const
 {
   if (name.empty())
     return &cppTypeTreeRoot_;
-  size_t nameBegPos = 0;
-  size_t nameEndPos = name.find("::", nameBegPos);
-  if (nameEndPos == std::string::npos)
+  auto nameEndPos = name.find("::");
+  if (nameEndPos == boost::string_view::npos)
   {
     for (; typeNode != NULL; typeNode = typeNode->parent)
     {
@@ -157,18 +640,16 @@ const CppTypeTreeNode* CppProgram::findTypeNode(const std::string& name, const C
   }
   else
   {
-    auto nameToLookFor = name.substr(nameBegPos, nameEndPos - nameBegPos);
-    typeNode           = findTypeNode(nameToLookFor, typeNode);
+    typeNode = findTypeNodeNoCache(name.substr(0, nameEndPos), typeNode);
     if (!typeNode)
       return nullptr;
     do
     {
-      nameBegPos = nameEndPos + 2;
-      nameEndPos = name.find("::", nameBegPos);
-      if (nameEndPos == std::string::npos)
+      const auto nameBegPos = nameEndPos + 2;
+      nameEndPos            = name.find("::", nameBegPos);
+      if (nameEndPos == boost::string_view::npos)
         nameEndPos = name.length();
-      nameToLookFor = name.substr(nameBegPos, nameEndPos - nameBegPos);
-      auto itr      = typeNode->children.find(nameToLookFor);
+      auto itr = typeNode->children.find(name.substr(nameBegPos, nameEndPos - nameBegPos));
       if (itr == typeNode->children.end())
         return nullptr;
       typeNode = &itr->second;
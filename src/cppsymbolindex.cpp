@@ -0,0 +1,203 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cppsymbolindex.h"
+
+#include "cppobj-accessor.h"
+
+#include <algorithm>
+
+static bool symbolNameLess(const CppSymbol& lhs, const CppSymbol& rhs)
+{
+  return lhs.name < rhs.name;
+}
+
+static boost::string_view stripGlobalScope(boost::string_view name)
+{
+  if (name.starts_with("::"))
+    name.remove_prefix(2);
+  return name;
+}
+
+CppSymbolIndex::CppSymbolIndex(const std::vector<CppCompoundPtr>& fileAsts)
+{
+  for (const auto& fileAst : fileAsts)
+    addSymbols(fileAst.get(), std::string(), fileAst.get());
+
+  std::stable_sort(symbols_.begin(), symbols_.end(), symbolNameLess);
+}
+
+void CppSymbolIndex::addFiles(const std::vector<const CppCompound*>& fileAsts)
+{
+  const auto numOldSymbols = symbols_.size();
+  for (const auto* fileAst : fileAsts)
+    addSymbols(fileAst, std::string(), fileAst);
+
+  // Merge is stable and so new symbols come after old ones of same name.
+  const auto newSymbolsBeg = symbols_.begin() + numOldSymbols;
+  std::stable_sort(newSymbolsBeg, symbols_.end(), symbolNameLess);
+  std::inplace_merge(symbols_.begin(), newSymbolsBeg, symbols_.end(), symbolNameLess);
+}
+
+void CppSymbolIndex::removeFile(const CppCompound* fileAst)
+{
+  symbols_.erase(std::remove_if(symbols_.begin(),
+                                symbols_.end(),
+                                [fileAst](const CppSymbol& symbol) { return symbol.file == fileAst; }),
+                 symbols_.end());
+}
+
+CppSymbolRange CppSymbolIndex::find(boost::string_view name) const
+{
+  name           = stripGlobalScope(name);
+  const auto beg = std::lower_bound(symbols_.begin(),
+                                    symbols_.end(),
+                                    name,
+                                    [](const CppSymbol& symbol, boost::string_view n) { return symbol.name < n; });
+  const auto end = std::upper_bound(
+    beg, symbols_.end(), name, [](boost::string_view n, const CppSymbol& symbol) { return n < symbol.name; });
+  return CppSymbolRange(beg, end);
+}
+
+CppSymbolRange CppSymbolIndex::findPrefix(boost::string_view prefix) const
+{
+  prefix         = stripGlobalScope(prefix);
+  const auto beg = std::lower_bound(symbols_.begin(),
+                                    symbols_.end(),
+                                    prefix,
+                                    [](const CppSymbol& symbol, boost::string_view p) { return symbol.name < p; });
+  const auto end = std::find_if(beg, symbols_.end(), [prefix](const CppSymbol& symbol) {
+    return !boost::string_view(symbol.name).starts_with(prefix);
+  });
+  return CppSymbolRange(beg, end);
+}
+
+void CppSymbolIndex::addSymbol(const std::string& scope,
+                               const std::string& name,
+                               const CppObj*      obj,
+                               const CppCompound* file)
+{
+  if (name.empty())
+    return;
+  auto qualifiedName = stripGlobalScope(name);
+  if (scope.empty())
+    symbols_.push_back(CppSymbol{qualifiedName.to_string(), obj, file});
+  else
+    symbols_.push_back(CppSymbol{scope + "::" + qualifiedName.to_string(), obj, file});
+}
+
+void CppSymbolIndex::addSymbols(const CppCompound* compound, const std::string& scope, const CppCompound* file)
+{
+  for (const auto& mem : compound->members())
+  {
+    const auto* obj = mem.get();
+    switch (obj->objType_)
+    {
+      case CppObjType::kCompound:
+      {
+        auto* nested = static_cast<const CppCompound*>(obj);
+        if (isNamespaceLike(nested) && !nested->name().empty())
+        {
+          addSymbol(scope, nested->name(), nested, file);
+          addSymbols(nested, scope.empty() ? nested->name() : scope + "::" + nested->name(), file);
+        }
+        else if (isNamespaceLike(nested) || (nested->compoundType() == CppCompoundType::kExternCBlock))
+        {
+          // Members of anonymous namespace, anonymous class, and extern "C" block belong to enclosing scope.
+          addSymbols(nested, scope, file);
+        }
+      }
+      break;
+
+      case CppObjType::kFunction:
+      case CppObjType::kConstructor:
+      case CppObjType::kDestructor:
+      case CppObjType::kTypeConverter:
+      case CppObjType::kFunctionPtr:
+        addSymbol(scope, static_cast<const CppFunctionBase*>(obj)->name_, obj, file);
+        break;
+
+      case CppObjType::kVar:
+        addSymbol(scope, static_cast<const CppVar*>(obj)->name(), obj, file);
+        break;
+
+      case CppObjType::kVarList:
+      {
+        auto* varList = static_cast<const CppVarList*>(obj);
+        addSymbol(scope, varList->firstVar()->name(), obj, file);
+        for (const auto& varDecl : varList->varDeclList())
+          addSymbol(scope, varDecl.name(), obj, file);
+      }
+      break;
+
+      case CppObjType::kTypedefName:
+        addSymbol(scope, static_cast<const CppTypedefName*>(obj)->var_->name(), obj, file);
+        break;
+
+      case CppObjType::kTypedefNameList:
+      {
+        auto* varList = static_cast<const CppTypedefList*>(obj)->varList_.get();
+        addSymbol(scope, varList->firstVar()->name(), obj, file);
+        for (const auto& varDecl : varList->varDeclList())
+          addSymbol(scope, varDecl.name(), obj, file);
+      }
+      break;
+
+      case CppObjType::kUsingDecl:
+        addSymbol(scope, static_cast<const CppUsingDecl*>(obj)->name_, obj, file);
+        break;
+
+      case CppObjType::kFwdClsDecl:
+      {
+        auto* fwdCls = static_cast<const CppFwdClsDecl*>(obj);
+        if (!(fwdCls->attr() & kFriend))
+          addSymbol(scope, fwdCls->name_, obj, file);
+      }
+      break;
+
+      case CppObjType::kEnum:
+      {
+        auto* enm = static_cast<const CppEnum*>(obj);
+        addSymbol(scope, enm->name_, obj, file);
+        if (!enm->itemList_)
+          break;
+        const auto enumScope = enm->name_.empty() ? scope : (scope.empty() ? enm->name_ : scope + "::" + enm->name_);
+        for (const auto& enmItem : *(enm->itemList_))
+        {
+          addSymbol(enumScope, enmItem->name_, obj, file);
+          // Items of unscoped enum are also visible in enclosing scope.
+          if (!enm->isClass_ && (enumScope != scope))
+            addSymbol(scope, enmItem->name_, obj, file);
+        }
+      }
+      break;
+
+      case CppObjType::kHashDefine:
+        addSymbol(std::string(), static_cast<const CppDefine*>(obj)->name_, obj, file);
+        break;
+
+      default:
+        break;
+    }
+  }
+}
@@ -0,0 +1,162 @@
+/*
+   The MIT License (MIT)
+
+   Copyright (c) 2018 Satya Das
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+   the Software, and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+   FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+   COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cpptracer.h"
+
+#include <fstream>
+#include <ostream>
+
+namespace {
+
+void writeJsonString(std::ostream& stm, const std::string& str)
+{
+  static const char hexDigits[] = "0123456789abcdef";
+
+  stm << '"';
+  for (const auto c : str)
+  {
+    switch (c)
+    {
+      case '"':
+        stm << "\\\"";
+        break;
+      case '\\':
+        stm << "\\\\";
+        break;
+      case '\n':
+        stm << "\\n";
+        break;
+      case '\t':
+        stm << "\\t";
+        break;
+
+      default:
+        if (static_cast<unsigned char>(c) < 0x20)
+          stm << "\\u00" << hexDigits[(c >> 4) & 0xF] << hexDigits[c & 0xF];
+        else
+          stm << c;
+        break;
+    }
+  }
+  stm << '"';
+}
+
+} // namespace
+
+CppTracer::CppTracer(Clock::duration minDuration)
+  : minDuration_(minDuration)
+  , startTime_(Clock::now())
+{
+}
+
+std::uint32_t CppTracer::threadIdx()
+{
+  const auto id = std::this_thread::get_id();
+  for (size_t i = 0; i < threadIds_.size(); ++i)
+  {
+    if (threadIds_[i] == id)
+      return static_cast<std::uint32_t>(i);
+  }
+
+  threadIds_.push_back(id);
+  threadNames_.push_back(threadIds_.size() == 1 ? "main" : "worker " + std::to_string(threadIds_.size() - 1));
+  return static_cast<std::uint32_t>(threadIds_.size() - 1);
+}
+
+void CppTracer::begin(const char* name, std::string file, std::size_t numBytes)
+{
+  const auto                  time = Clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.push_back(Event{name, 'B', time, threadIdx(), std::move(file), numBytes});
+}
+
+void CppTracer::end(const char* name, std::size_t numBytes)
+{
+  const auto                  time = Clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.push_back(Event{name, 'E', time, threadIdx(), std::string(), numBytes});
+}
+
+void CppTracer::recordIfSlow(const char* name, Clock::time_point startTime, Clock::time_point endTime)
+{
+  if (endTime - startTime < minDuration_)
+    return;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto                  tid = threadIdx();
+  events_.push_back(Event{name, 'B', startTime, tid, std::string(), 0});
+  events_.push_back(Event{name, 'E', endTime, tid, std::string(), 0});
+}
+
+void CppTracer::threadName(std::string name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  threadNames_[threadIdx()] = std::move(name);
+}
+
+void CppTracer::writeJson(std::ostream& stm) const
+{
+  stm << "{\"traceEvents\":[\n";
+  const char* sep = "";
+  for (size_t tid = 0; tid < threadNames_.size(); ++tid)
+  {
+    stm << sep << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":";
+    writeJsonString(stm, threadNames_[tid]);
+    stm << "}}";
+    sep = ",\n";
+  }
+
+  for (const auto& event : events_)
+  {
+    const auto micros = std::chrono::duration<double, std::micro>(event.time - startTime_).count();
+    stm << sep << "{\"name\":";
+    writeJsonString(stm, event.name);
+    stm << ",\"cat\":\"cppparser\",\"ph\":\"" << event.phase << "\",\"ts\":" << std::fixed << micros
+        << std::defaultfloat << ",\"pid\":1,\"tid\":" << event.tid;
+    // Viewers merge args of begin and end events.
+    if (!event.file.empty() || event.numBytes)
+    {
+      stm << ",\"args\":{";
+      if (!event.file.empty())
+      {
+        stm << "\"file\":";
+        writeJsonString(stm, event.file);
+      }
+      if (event.numBytes)
+        stm << (event.file.empty() ? "" : ",") << "\"bytes\":" << event.numBytes;
+      stm << '}';
+    }
+    stm << '}';
+    sep = ",\n";
+  }
+  stm << "\n]}\n";
+}
+
+bool CppTracer::writeJson(const std::string& path) const
+{
+  std::ofstream stm(path);
+  if (!stm)
+    return false;
+  writeJson(stm);
+  return stm.good();
+}
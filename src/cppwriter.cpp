@@ -29,41 +29,72 @@
 #include "cppobj-accessor.h"
 #include "cppvar-accessor.h"
 
+#include "cppoutputbuffer.h"
+#include "cppparallel.h"
+#include "cpptracer.h"
+
+#include <boost/filesystem.hpp>
+
 //////////////////////////////////////////////////////////////////////////
 
 namespace {
+/// Index of storage in stream where indentation level of preprocessor directives emitted in that stream is kept.
+static const int kPreproIndentIdx = std::ios_base::xalloc();
+
+static CppIndent preproIndent(std::ostream& stm)
+{
+  return CppIndent(static_cast<std::uint16_t>(stm.iword(kPreproIndentIdx)));
+}
+
+static void incPreproIndent(std::ostream& stm)
+{
+  ++stm.iword(kPreproIndentIdx);
+}
+
+static CppIndent decPreproIndent(std::ostream& stm)
+{
+  auto& level = stm.iword(kPreproIndentIdx);
+  if (level)
+    --level;
+  return preproIndent(stm);
+}
+
 static void emitAttribute(std::uint32_t attr, std::ostream& stm)
 {
+  CppOutputInserter out(stm);
+
   if (attr & kStatic)
-    stm << "static ";
+    out << "static ";
   else if (attr & kExtern)
-    stm << "extern ";
+    out << "extern ";
   else if (attr & kExternC)
-    stm << "extern C ";
+    out << "extern C ";
 
   if (attr & kConst)
-    stm << "const ";
+    out << "const ";
   if (attr & kVolatile)
-    stm << "volatile ";
+    out << "volatile ";
   if (attr & kMutable)
-    stm << "mutable ";
+    out << "mutable ";
 }
 
 static void emitTypeModifier(const CppTypeModifier& modifier, std::ostream& stm)
 {
+  CppOutputInserter out(stm);
+
   std::uint8_t constBit = 0;
   for (constBit = 0; constBit < modifier.ptrLevel_; ++constBit)
   {
     if (modifier.constBits_ & (1 << constBit))
-      stm << " const ";
-    stm << "*";
+      out << " const ";
+    out << "*";
   }
   if (modifier.constBits_ & (1 << constBit))
-    stm << " const";
+    out << " const";
   if (modifier.refType_ == CppRefType::kByRef)
-    stm << '&';
+    out << '&';
   else if (modifier.refType_ == CppRefType::kRValRef)
-    stm << "&&";
+    out << "&&";
 }
 } // namespace
 
@@ -74,6 +105,8 @@ void CppWriter::emit(const CppObj* cppObj, std::ostream& stm, CppIndent indentat
 
 void CppWriter::emit(const CppObj* cppObj, std::ostream& stm, CppIndent indentation, bool noNewLine) const
 {
+  CppOutputInserter out(stm);
+
   switch (cppObj->objType_)
   {
     case CppObjType::kHashDefine:
@@ -93,7 +126,7 @@ void CppWriter::emit(const CppObj* cppObj, std::ostream& stm, CppIndent indentat
     {
       emitVar((CppVar*) cppObj, stm, indentation);
       if (!noNewLine)
-        stm << ";\n";
+        out << ";\n";
       return;
     }
     case CppObjType::kVarList:
@@ -133,7 +166,7 @@ void CppWriter::emit(const CppObj* cppObj, std::ostream& stm, CppIndent indentat
     case CppObjType::kExpression:
       emitExpr((CppExpr*) cppObj, stm, indentation);
       if (!noNewLine)
-        stm << ";\n";
+        out << ";\n";
       break;
     case CppObjType::kSwitchBlock:
       return emitSwitchBlock(static_cast<const CppSwitchBlock*>(cppObj), stm, indentation);
@@ -150,20 +183,26 @@ void CppWriter::emit(const CppObj* cppObj, std::ostream& stm, CppIndent indentat
 
 void CppWriter::emitDefine(const CppDefine* defObj, std::ostream& stm) const
 {
-  stm << '#' << preproIndent_ << "define " << defObj->name_;
+  CppOutputInserter out(stm);
+
+  out << '#' << preproIndent(stm) << "define " << defObj->name_;
   if (!defObj->defn_.empty())
-    stm << '\t' << defObj->defn_;
-  stm << '\n';
+    out << '\t' << defObj->defn_;
+  out << '\n';
 }
 
 void CppWriter::emitUndef(const CppUndef* undefObj, std::ostream& stm) const
 {
-  stm << '#' << preproIndent_ << "undef " << undefObj->name_ << '\n';
+  CppOutputInserter out(stm);
+
+  out << '#' << preproIndent(stm) << "undef " << undefObj->name_ << '\n';
 }
 
 void CppWriter::emitInclude(const CppInclude* includeObj, std::ostream& stm) const
 {
-  stm << '#' << preproIndent_ << "include " << includeObj->name_ << '\n';
+  CppOutputInserter out(stm);
+
+  out << '#' << preproIndent(stm) << "include " << includeObj->name_ << '\n';
 }
 void CppWriter::emitHashIf(const CppHashIf* hashIfObj, std::ostream& stm) const
 {
@@ -172,36 +211,40 @@ void CppWriter::emitHashIf(const CppHashIf* hashIfObj, std::ostream& stm) const
 
 void CppWriter::emitEndIf(std::ostream& stm) const
 {
-  stm << '#' << --preproIndent_ << "endif\n";
+  CppOutputInserter out(stm);
+
+  out << '#' << decPreproIndent(stm) << "endif\n";
 }
 
 void CppWriter::emitHashIf(CppHashIf::CondType condType, const std::string& cond, std::ostream& stm) const
 {
+  CppOutputInserter out(stm);
+
   switch (condType)
   {
     case CppHashIf::kIf:
-      stm << '#' << preproIndent_ << "if " << cond << '\n';
-      ++preproIndent_;
+      out << '#' << preproIndent(stm) << "if " << cond << '\n';
+      incPreproIndent(stm);
       break;
 
     case CppHashIf::kIfDef:
-      stm << '#' << preproIndent_ << "ifdef " << cond << '\n';
-      ++preproIndent_;
+      out << '#' << preproIndent(stm) << "ifdef " << cond << '\n';
+      incPreproIndent(stm);
       break;
 
     case CppHashIf::kIfNDef:
-      stm << '#' << preproIndent_ << "ifndef " << cond << '\n';
-      ++preproIndent_;
+      out << '#' << preproIndent(stm) << "ifndef " << cond << '\n';
+      incPreproIndent(stm);
       break;
 
     case CppHashIf::kElIf:
-      stm << '#' << --preproIndent_ << "elif " << cond << '\n';
-      ++preproIndent_;
+      out << '#' << decPreproIndent(stm) << "elif " << cond << '\n';
+      incPreproIndent(stm);
       break;
 
     case CppHashIf::kElse:
-      stm << '#' << --preproIndent_ << "else " << cond << '\n';
-      ++preproIndent_;
+      out << '#' << decPreproIndent(stm) << "else " << cond << '\n';
+      incPreproIndent(stm);
       break;
 
     case CppHashIf::kEndIf:
@@ -212,22 +255,28 @@ void CppWriter::emitHashIf(CppHashIf::CondType condType, const std::string& cond
 
 void CppWriter::emitPragma(const CppPragma* pragmaObj, std::ostream& stm) const
 {
-  stm << '#' << preproIndent_ << "pragma " << pragmaObj->defn_ << '\n';
+  CppOutputInserter out(stm);
+
+  out << '#' << preproIndent(stm) << "pragma " << pragmaObj->defn_ << '\n';
 }
 
 void CppWriter::emitBlob(const CppBlob* blobObj, std::ostream& stm) const
 {
-  stm << blobObj->blob_;
+  CppOutputInserter out(stm);
+
+  out << blobObj->blob_;
 }
 
 void CppWriter::emitVarType(const CppVarType* varTypeObj, std::ostream& stm) const
 {
+  CppOutputInserter out(stm);
+
   const auto attr = varTypeObj->typeAttr() | (isConst(varTypeObj) ? CppIdentifierAttrib::kConst : 0);
   emitAttribute(attr, stm);
   if (varTypeObj->compound())
     emit(varTypeObj->compound(), stm, CppIndent(), true);
   else
-    stm << varTypeObj->baseType();
+    out << varTypeObj->baseType();
   const auto&           origTypeModifier = varTypeObj->typeModifier();
   const CppTypeModifier typeModifier{
     origTypeModifier.refType_, origTypeModifier.ptrLevel_, origTypeModifier.constBits_ & ~1};
@@ -241,46 +290,50 @@ void CppWriter::emitVar(const CppVar* varObj, std::ostream& stm, CppIndent inden
 
 void CppWriter::emitVarDecl(std::ostream& stm, const CppVarDecl& varDecl, bool skipName) const
 {
+  CppOutputInserter out(stm);
+
   if (!skipName && !varDecl.name().empty())
-    stm << varDecl.name();
+    out << varDecl.name();
   for (const auto& arrSize : varDecl.arraySizes())
   {
-    stm << '[';
+    out << '[';
     if (arrSize)
       emitExpr(arrSize.get(), stm);
-    stm << ']';
+    out << ']';
   }
   if (varDecl.assignType() == AssignType::kUsingEqual)
   {
-    stm << " = ";
+    out << " = ";
     emit(varDecl.assignValue(), stm, CppIndent(), true);
   }
   else if (varDecl.assignType() == AssignType::kUsingBracket)
   {
-    stm << '(';
+    out << '(';
     if (varDecl.assignValue())
       emit(varDecl.assignValue(), stm, CppIndent(), true);
-    stm << ')';
+    out << ')';
   }
   else if (varDecl.assignType() == AssignType::kUsingBraces)
   {
-    stm << '{';
+    out << '{';
     if (varDecl.assignValue())
       emit(varDecl.assignValue(), stm, CppIndent(), true);
-    stm << '}';
+    out << '}';
   }
 }
 
 void CppWriter::emitVar(const CppVar* varObj, std::ostream& stm, CppIndent indentation, bool skipName) const
 {
-  stm << indentation;
+  CppOutputInserter out(stm);
+
+  out << indentation;
   if (!varObj->apidecor().empty())
   {
-    stm << varObj->apidecor() << ' ';
+    out << varObj->apidecor() << ' ';
   }
   emitVarType(varObj->varType(), stm);
   if (!skipName && !varObj->name().empty())
-    stm << ' ';
+    out << ' ';
   emitVarDecl(stm, varObj->varDecl(), skipName);
 }
 
@@ -288,43 +341,47 @@ void CppWriter::emitVarList(const CppVarList* varListObj,
                             std::ostream&     stm,
                             CppIndent         indentation /* = CppIndent()*/) const
 {
+  CppOutputInserter out(stm);
+
   emitVar(varListObj->firstVar().get(), stm, indentation);
   auto& varDeclList = varListObj->varDeclList();
   for (size_t i = 0; i < varDeclList.size(); ++i)
   {
-    stm << ", ";
+    out << ", ";
     const auto& decl = varDeclList[i];
     emitTypeModifier(decl, stm);
     emitVarDecl(stm, decl, false);
   }
 
-  stm << ";\n";
+  out << ";\n";
 }
 
 void CppWriter::emitEnum(const CppEnum* enmObj, std::ostream& stm, bool emitNewLine, CppIndent indentation) const
 {
-  stm << indentation << "enum";
+  CppOutputInserter out(stm);
+
+  out << indentation << "enum";
   if (enmObj->isClass_)
-    stm << " class";
+    out << " class";
   if (!enmObj->name_.empty())
-    stm << ' ' << enmObj->name_;
+    out << ' ' << enmObj->name_;
   if (!enmObj->underlyingType_.empty())
-    stm << " : " << enmObj->underlyingType_;
+    out << " : " << enmObj->underlyingType_;
   if (enmObj->itemList_)
   {
     const bool isEnumBodyBlob = !enmObj->itemList_->empty() && enmObj->itemList_->front()->val_
                                 && (enmObj->itemList_->front()->val_->objType_ == CppBlob::kObjectType);
     if (isEnumBodyBlob)
     {
-      stm << " {";
+      out << " {";
       emit(enmObj->itemList_->front()->val_.get(), stm, indentation);
-      stm << '}';
+      out << '}';
     }
     else
     {
-      stm << '\n';
-      stm << indentation++ << "{\n";
-      for (auto enmItem : *(enmObj->itemList_))
+      out << '\n';
+      out << indentation++ << "{\n";
+      for (const auto& enmItem : *(enmObj->itemList_))
       {
         if (enmItem->name_.empty())
         {
@@ -332,55 +389,61 @@ void CppWriter::emitEnum(const CppEnum* enmObj, std::ostream& stm, bool emitNewL
         }
         else
         {
-          stm << indentation << enmItem->name_;
+          out << indentation << enmItem->name_;
           if (enmItem->val_ && isExpr(enmItem->val_.get()))
           {
             auto* expr = static_cast<CppExpr*>(enmItem->val_.get());
-            stm << " = ";
+            out << " = ";
             emitExpr(expr, stm);
           }
           if (enmItem != enmObj->itemList_->back())
-            stm << ",\n";
+            out << ",\n";
           else
-            stm << '\n';
+            out << '\n';
         }
       }
-      stm << --indentation << "}";
+      out << --indentation << "}";
     }
   }
   if (emitNewLine)
-    stm << ";\n";
+    out << ";\n";
 }
 
 void CppWriter::emitTypedef(const CppTypedefName* typedefName,
                             std::ostream&         stm,
                             CppIndent             indentation /* = CppIndent()*/) const
 {
-  stm << indentation << "typedef ";
+  CppOutputInserter out(stm);
+
+  out << indentation << "typedef ";
   emitVar(typedefName->var_.get(), stm);
-  stm << ";\n";
+  out << ";\n";
 }
 
 void CppWriter::emitUsingDecl(const CppUsingDecl* usingDecl,
                               std::ostream&       stm,
                               CppIndent           indentation /* = CppIndent()*/) const
 {
+  CppOutputInserter out(stm);
+
   if (usingDecl->templateParamList())
     emitTemplSpec(usingDecl->templateParamList(), stm, indentation);
-  stm << indentation << "using " << usingDecl->name_;
+  out << indentation << "using " << usingDecl->name_;
   if (usingDecl->cppObj_)
   {
-    stm << " = ";
+    out << " = ";
     emit(usingDecl->cppObj_.get(), stm);
   }
-  stm << ";\n";
+  out << ";\n";
 }
 
 void CppWriter::emitTypedefList(const CppTypedefList* typedefList,
                                 std::ostream&         stm,
                                 CppIndent             indentation /* = CppIndent()*/) const
 {
-  stm << indentation << "typedef ";
+  CppOutputInserter out(stm);
+
+  out << indentation << "typedef ";
   emitVarList(typedefList->varList_.get(), stm);
 }
 
@@ -388,56 +451,62 @@ void CppWriter::emitFwdDecl(const CppFwdClsDecl* fwdDeclObj,
                             std::ostream&        stm,
                             CppIndent            indentation /* = CppIndent()*/) const
 {
+  CppOutputInserter out(stm);
+
   if (fwdDeclObj->templateParamList())
     emitTemplSpec(fwdDeclObj->templateParamList(), stm, indentation);
-  stm << indentation;
+  out << indentation;
   if (fwdDeclObj->attr() & kFriend)
-    stm << "friend ";
+    out << "friend ";
   if (fwdDeclObj->cmpType_ != CppCompoundType::kUnknownCompound)
-    stm << fwdDeclObj->cmpType_ << ' ';
+    out << fwdDeclObj->cmpType_ << ' ';
   if (!fwdDeclObj->apidecor_.empty())
-    stm << fwdDeclObj->apidecor_ << ' ';
-  stm << fwdDeclObj->name_ << ";\n";
+    out << fwdDeclObj->apidecor_ << ' ';
+  out << fwdDeclObj->name_ << ";\n";
 }
 
 void CppWriter::emitMacroCall(const CppMacroCall* macroCallObj,
                               std::ostream&       stm,
                               CppIndent           indentation /* = CppIndent()*/) const
 {
-  stm << indentation << macroCallObj->macroCall_ << '\n';
+  CppOutputInserter out(stm);
+
+  out << indentation << macroCallObj->macroCall_ << '\n';
 }
 
 void CppWriter::emitTemplSpec(const CppTemplateParamList* templSpec, std::ostream& stm, CppIndent indentation) const
 {
-  stm << indentation << "template <";
+  CppOutputInserter out(stm);
+
+  out << indentation << "template <";
   if (templSpec)
   {
     const char* sep = "";
     for (auto& param : *templSpec)
     {
-      stm << sep;
+      out << sep;
       if (param->paramType_)
       {
         if (param->paramType_->objType_ == CppVarType::kObjectType)
           emitVarType(static_cast<const CppVarType*>(param->paramType_.get()), stm);
         else
           emitFunctionPtr(static_cast<const CppFunctionPointer*>(param->paramType_.get()), stm, false);
-        stm << ' ';
+        out << ' ';
       }
       else
       {
-        stm << "typename ";
+        out << "typename ";
       }
-      stm << param->paramName_;
+      out << param->paramName_;
       if (param->defaultArg())
       {
-        stm << " = ";
+        out << " = ";
         emit(param->defaultArg(), stm, CppIndent(), true);
       }
       sep = ", ";
     }
   }
-  stm << ">\n";
+  out << ">\n";
 }
 
 void CppWriter::emitCompound(const CppCompound* compoundObj,
@@ -445,42 +514,44 @@ void CppWriter::emitCompound(const CppCompound* compoundObj,
                              CppIndent          indentation,
                              bool               emitNewLine) const
 {
+  CppOutputInserter out(stm);
+
   if (isNamespaceLike(compoundObj))
   {
     if (compoundObj->templateParamList())
     {
       emitTemplSpec(compoundObj->templateParamList(), stm, indentation);
     }
-    stm << indentation << compoundObj->compoundType() << ' ';
+    out << indentation << compoundObj->compoundType() << ' ';
     if (!compoundObj->apidecor().empty())
-      stm << compoundObj->apidecor() << ' ';
-    stm << compoundObj->name();
+      out << compoundObj->apidecor() << ' ';
+    out << compoundObj->name();
   }
   if (compoundObj->inheritanceList())
   {
     ++indentation;
     char sep = ':';
-    stm << ' ';
+    out << ' ';
     for (CppInheritanceList::const_iterator inhItr = compoundObj->inheritanceList()->begin();
          inhItr != compoundObj->inheritanceList()->end();
          ++inhItr)
     {
-      stm << sep << ' ' << inhItr->inhType << ' ' << inhItr->baseName;
+      out << sep << ' ' << inhItr->inhType << ' ' << inhItr->baseName;
       sep = ',';
     }
     --indentation;
   }
   if (isNamespaceLike(compoundObj))
-    stm << '\n' << indentation++ << "{\n";
+    out << '\n' << indentation++ << "{\n";
   else if (compoundObj->compoundType() == CppCompoundType::kExternCBlock)
-    stm << indentation++ << "extern \"C\" {\n";
+    out << indentation++ << "extern \"C\" {\n";
 
   CppAccessType lastAccessType = CppAccessType::kUnknown;
   forEachMember(compoundObj, [&](const CppObj* memObj) {
     if (isClassLike(compoundObj) && memObj->accessType_ != CppAccessType::kUnknown
         && lastAccessType != memObj->accessType_)
     {
-      stm << --indentation << memObj->accessType_ << ':' << '\n';
+      out << --indentation << memObj->accessType_ << ':' << '\n';
       lastAccessType = memObj->accessType_;
       ++indentation;
     }
@@ -491,17 +562,17 @@ void CppWriter::emitCompound(const CppCompound* compoundObj,
 
   if (isNamespaceLike(compoundObj))
   {
-    stm << --indentation;
-    stm << '}';
+    out << --indentation;
+    out << '}';
     if (emitNewLine)
     {
       if (isClassLike(compoundObj))
-        stm << ';';
-      stm << '\n';
+        out << ';';
+      out << '\n';
     }
   }
   else if (compoundObj->compoundType() == CppCompoundType::kExternCBlock)
-    stm << indentation << "}\n";
+    out << indentation << "}\n";
 }
 
 void CppWriter::emitParamList(const CppParamVector* paramListObj, std::ostream& stm) const
@@ -511,10 +582,12 @@ void CppWriter::emitParamList(const CppParamVector* paramListObj, std::ostream&
 
 void CppWriter::emitParamList(const CppParamVector* paramListObj, std::ostream& stm, bool skipParamName) const
 {
+  CppOutputInserter out(stm);
+
   for (auto prmItr = paramListObj->begin(); prmItr != paramListObj->end(); ++prmItr)
   {
     if (prmItr != paramListObj->begin())
-      stm << ", ";
+      out << ", ";
     auto& param = *prmItr;
     switch (param->objType_)
     {
@@ -537,73 +610,75 @@ void CppWriter::emitFunction(const CppFunction* funcObj,
                              bool               skipParamName,
                              bool               emitNewLine) const
 {
+  CppOutputInserter out(stm);
+
   if (funcObj->templateParamList())
     emitTemplSpec(funcObj->templateParamList(), stm, indentation);
 
   if ((funcObj->attr() & (kFuncParam | kTypedef)) == 0)
-    stm << indentation;
+    out << indentation;
   if (!funcObj->decor1().empty())
-    stm << funcObj->decor1() << ' ';
+    out << funcObj->decor1() << ' ';
   if (funcObj->hasAttr(kStatic))
-    stm << "static ";
+    out << "static ";
   else if (funcObj->hasAttr(kExtern))
-    stm << "extern ";
+    out << "extern ";
   else if (funcObj->hasAttr(kVirtual) && !(funcObj->hasAttr(kOverride) || funcObj->hasAttr(kFinal)))
-    stm << "virtual ";
+    out << "virtual ";
   else if (funcObj->hasAttr(kInline))
-    stm << "inline ";
+    out << "inline ";
   else if (funcObj->hasAttr(kExplicit))
-    stm << "explicit ";
+    out << "explicit ";
   else if (funcObj->hasAttr(kFriend))
-    stm << "friend ";
+    out << "friend ";
   if (funcObj->hasAttr(kTrailingRet))
-    stm << "auto";
+    out << "auto";
   else
     emitVarType(funcObj->retType_.get(), stm);
   if (funcObj->objType_ == CppObjType::kFunctionPtr)
-    stm << " (";
+    out << " (";
   else
-    stm << ' ';
+    out << ' ';
   if (!funcObj->decor2().empty())
-    stm << funcObj->decor2() << ' ';
+    out << funcObj->decor2() << ' ';
   if (funcObj->objType_ == CppObjType::kFunctionPtr)
   {
-    stm << '*';
+    out << '*';
     if (!skipName)
-      stm << funcObj->name_ << ") ";
+      out << funcObj->name_ << ") ";
   }
   else if (!skipName)
   {
-    stm << funcObj->name_;
+    out << funcObj->name_;
   }
-  stm << '(';
+  out << '(';
   if (funcObj->params())
     emitParamList(funcObj->params(), stm, skipParamName);
-  stm << ')';
+  out << ')';
 
   if ((funcObj->attr() & kConst) == kConst)
-    stm << " const";
+    out << " const";
   if ((funcObj->attr() & kPureVirtual) == kPureVirtual)
-    stm << " = 0";
+    out << " = 0";
   else if ((funcObj->attr() & kOverride) == kOverride)
-    stm << " override";
+    out << " override";
   else if ((funcObj->attr() & kFinal) == kFinal)
-    stm << " final";
+    out << " final";
 
   if (funcObj->attr() & kTrailingRet)
   {
-    stm << " -> ";
+    out << " -> ";
     emitVarType(funcObj->retType_.get(), stm);
   }
   if (!skipParamName && funcObj->defn() && (getEmittingType() != kHeader))
   {
-    stm << '\n' << indentation++ << "{\n";
+    out << '\n' << indentation++ << "{\n";
     emitCompound(funcObj->defn(), stm, indentation);
-    stm << --indentation << "}\n";
+    out << --indentation << "}\n";
   }
   else if (emitNewLine && ((funcObj->attr() & kFuncParam) == 0))
   {
-    stm << ";\n";
+    out << ";\n";
   }
 }
 
@@ -620,8 +695,10 @@ void CppWriter::emitFunctionPtr(const CppFunctionPointer* funcPtrObj,
                                 bool                      emitNewLine,
                                 CppIndent                 indentation) const
 {
+  CppOutputInserter out(stm);
+
   if (funcPtrObj->attr() & kTypedef)
-    stm << indentation << "typedef ";
+    out << indentation << "typedef ";
   emitFunction((CppFunction*) funcPtrObj, stm, emitNewLine, indentation);
 }
 
@@ -630,22 +707,24 @@ void CppWriter::emitConstructor(const CppConstructor* ctorObj,
                                 CppIndent             indentation,
                                 bool                  skipParamName) const
 {
+  CppOutputInserter out(stm);
+
   if (ctorObj->templateParamList())
   {
     emitTemplSpec(ctorObj->templateParamList(), stm, indentation);
   }
-  stm << indentation;
+  out << indentation;
   if (!ctorObj->decor1().empty())
-    stm << ctorObj->decor1() << ' ';
+    out << ctorObj->decor1() << ' ';
   if (ctorObj->attr() & kInline)
-    stm << "inline ";
+    out << "inline ";
   else if (ctorObj->attr() & kExplicit)
-    stm << "explicit ";
-  stm << ctorObj->name_;
-  stm << '(';
+    out << "explicit ";
+  out << ctorObj->name_;
+  out << '(';
   if (ctorObj->params())
     emitParamList(ctorObj->params(), stm, skipParamName);
-  stm << ')';
+  out << ')';
   if (!skipParamName && ctorObj->memInitList_)
   {
     char sep = ':';
@@ -654,25 +733,25 @@ void CppWriter::emitConstructor(const CppConstructor* ctorObj,
          memInitItr != ctorObj->memInitList_->end();
          ++memInitItr)
     {
-      stm << '\n';
-      stm << indentation << sep << ' ' << memInitItr->first << '(';
-      emitExpr(memInitItr->second, stm);
-      stm << ')';
+      out << '\n';
+      out << indentation << sep << ' ' << memInitItr->first << '(';
+      emitExpr(memInitItr->second.get(), stm);
+      out << ')';
       sep = ',';
     }
     --indentation;
   }
   if (!skipParamName && ctorObj->defn())
   {
-    stm << '\n' << indentation++ << "{\n";
+    out << '\n' << indentation++ << "{\n";
     emitCompound(ctorObj->defn(), stm, indentation);
-    stm << --indentation << "}\n";
+    out << --indentation << "}\n";
   }
   else
   {
     if (isDeleted(ctorObj))
-      stm << " = delete";
-    stm << ";\n";
+      out << " = delete";
+    out << ";\n";
   }
 }
 
@@ -685,28 +764,30 @@ void CppWriter::emitDestructor(const CppDestructor* dtorObj,
                                std::ostream&        stm,
                                CppIndent            indentation /* = CppIndent()*/) const
 {
+  CppOutputInserter out(stm);
+
   if (dtorObj->templateParamList())
     emitTemplSpec(dtorObj->templateParamList(), stm, indentation);
-  stm << indentation;
+  out << indentation;
   if (!dtorObj->decor1().empty())
-    stm << dtorObj->decor1() << ' ';
+    out << dtorObj->decor1() << ' ';
   if (dtorObj->attr() & kInline)
-    stm << "inline ";
+    out << "inline ";
   else if (dtorObj->attr() & kExplicit)
-    stm << "explicit ";
+    out << "explicit ";
   else if (dtorObj->attr() & kVirtual)
-    stm << "virtual ";
-  stm << dtorObj->name_ << "()";
+    out << "virtual ";
+  out << dtorObj->name_ << "()";
 
   if (dtorObj->defn())
   {
-    stm << '\n' << indentation++ << "{\n";
+    out << '\n' << indentation++ << "{\n";
     emitCompound(dtorObj->defn(), stm, indentation);
-    stm << --indentation << "}\n";
+    out << --indentation << "}\n";
   }
   else
   {
-    stm << ";\n";
+    out << ";\n";
   }
 }
 
@@ -714,25 +795,27 @@ void CppWriter::emitTypeConverter(const CppTypeConverter* typeConverterObj,
                                   std::ostream&           stm,
                                   CppIndent               indentation) const
 {
+  CppOutputInserter out(stm);
+
   if (typeConverterObj->templateParamList())
     emitTemplSpec(typeConverterObj->templateParamList(), stm, indentation);
-  stm << indentation << "operator ";
+  out << indentation << "operator ";
   emitVarType(typeConverterObj->to_.get(), stm);
-  stm << "()";
+  out << "()";
   if (typeConverterObj->attr() & kConst)
-    stm << " const";
+    out << " const";
   if (typeConverterObj->defn())
   {
-    stm << '\n';
-    stm << indentation << "{\n";
+    out << '\n';
+    out << indentation << "{\n";
     ++indentation;
     emitCompound(typeConverterObj->defn(), stm, indentation);
     --indentation;
-    stm << indentation << "}\n";
+    out << indentation << "}\n";
   }
   else
   {
-    stm << ";\n";
+    out << ";\n";
   }
 }
 
@@ -740,137 +823,141 @@ void CppWriter::emitDocComment(const CppDocComment* docCommentObj,
                                std::ostream&        stm,
                                CppIndent            indentation /* = CppIndent()*/) const
 {
-  stm << docCommentObj->doc_ << '\n';
+  CppOutputInserter out(stm);
+
+  out << docCommentObj->doc_ << '\n';
 }
 
 inline void emitOperator(std::ostream& stm, CppOperator op)
 {
+  CppOutputInserter out(stm);
+
   switch (op)
   {
     case kUnaryMinus:
-      stm << '-';
+      out << '-';
       break;
     case kBitToggle:
-      stm << '~';
+      out << '~';
       break;
     case kLogNot:
-      stm << '!';
+      out << '!';
       break;
     case kDerefer:
-      stm << '*';
+      out << '*';
       break;
     case kRefer:
-      stm << '&';
+      out << '&';
       break;
     case kPreIncrement:
     case kPostIncrement:
-      stm << "++";
+      out << "++";
       break;
     case kPreDecrement:
     case kPostDecrement:
-      stm << "--";
+      out << "--";
       break;
     case kPlus:
-      stm << '+';
+      out << '+';
       break;
     case kMinus:
-      stm << '-';
+      out << '-';
       break;
     case kMul:
-      stm << '*';
+      out << '*';
       break;
     case kDiv:
-      stm << '/';
+      out << '/';
       break;
     case kPercent:
-      stm << '%';
+      out << '%';
       break;
     case kAnd:
-      stm << "&&";
+      out << "&&";
       break;
     case kOr:
-      stm << "||";
+      out << "||";
       break;
     case kBitAnd:
-      stm << '&';
+      out << '&';
       break;
     case kBitOr:
-      stm << '|';
+      out << '|';
       break;
     case kXor:
-      stm << '^';
+      out << '^';
       break;
     case kEqual:
-      stm << '=';
+      out << '=';
       break;
     case kLess:
-      stm << '<';
+      out << '<';
       break;
     case kGreater:
-      stm << '>';
+      out << '>';
       break;
     case kPlusEqual:
-      stm << "+=";
+      out << "+=";
       break;
     case kMinusEqual:
-      stm << "-=";
+      out << "-=";
       break;
     case kMulEqual:
-      stm << "*=";
+      out << "*=";
       break;
     case kDivEqual:
-      stm << "/=";
+      out << "/=";
       break;
     case kPerEqual:
-      stm << "%=";
+      out << "%=";
       break;
     case kXorEqual:
-      stm << "^=";
+      out << "^=";
       break;
     case kAndEqual:
-      stm << "&=";
+      out << "&=";
       break;
     case kOrEqual:
-      stm << "|=";
+      out << "|=";
       break;
     case kLeftShift:
-      stm << "<<";
+      out << "<<";
       break;
     case kRightShift:
-      stm << ">>";
+      out << ">>";
       break;
     case kLShiftEqual:
-      stm << "<<=";
+      out << "<<=";
       break;
     case kRShiftEqual:
-      stm << ">>=";
+      out << ">>=";
       break;
     case kCmpEqual:
-      stm << "==";
+      out << "==";
       break;
     case kNotEqual:
-      stm << "!=";
+      out << "!=";
       break;
     case kLessEqual:
-      stm << "<=";
+      out << "<=";
       break;
     case kGreaterEqual:
-      stm << ">=";
+      out << ">=";
       break;
     case k3WayCmp:
-      stm << "<=>";
+      out << "<=>";
       break;
     case kComma:
-      stm << ',';
+      out << ',';
       break;
     case kDot:
-      stm << '.';
+      out << '.';
       break;
     case kArrow:
-      stm << "->";
+      out << "->";
       break;
     case kArrowStar:
-      stm << "->*";
+      out << "->*";
       break;
 
     default:
@@ -882,10 +969,12 @@ void CppWriter::emitExprAtom(const CppExprAtom& exprAtm,
                              std::ostream&      stm,
                              CppIndent          indentation /*= CppIndent()*/) const
 {
+  CppOutputInserter out(stm);
+
   switch (exprAtm.type)
   {
     case CppExprAtom::kAtom:
-      stm << *(exprAtm.atom);
+      out << exprAtm.atom();
       break;
     case CppExprAtom::kExpr:
       emitExpr(exprAtm.expr, stm);
@@ -898,207 +987,293 @@ void CppWriter::emitExprAtom(const CppExprAtom& exprAtm,
   }
 }
 
-void CppWriter::emitExpr(const CppExpr* exprObj, std::ostream& stm, CppIndent indentation /*= CppIndent()*/) const
+// Emits an expression given its flags, operator, and a function that emits the i-th atom.
+// It is shared by emitting of CppExpr and of nodes of CppExprPool.
+template <typename EmitAtom>
+static void emitExprImpl(short flags, CppOperator oper, const EmitAtom& emitAtom, std::ostream& stm)
 {
-  if (exprObj == NULL)
-    return;
-  stm << indentation;
-  if (exprObj->flags_ & CppExpr::kReturn)
-    stm << "return ";
-  if (exprObj->flags_ & CppExpr::kThrow)
-    stm << "throw ";
-  if (exprObj->flags_ & CppExpr::kInitializer)
-    stm << "{";
-  if (exprObj->flags_ & CppExpr::kBracketed)
-    stm << '(';
-  if (exprObj->flags_ & CppExpr::kNew)
-    stm << "new ";
-  if (exprObj->flags_ & CppExpr::kSizeOf)
-    stm << "sizeof(";
-  else if (exprObj->flags_ & CppExpr::kDelete)
-    stm << "delete ";
-  else if (exprObj->flags_ & CppExpr::kDeleteArray)
-    stm << "delete[] ";
-  if (exprObj->oper_ == kNone)
+  CppOutputInserter out(stm);
+
+  if (flags & CppExpr::kReturn)
+    out << "return ";
+  if (flags & CppExpr::kThrow)
+    out << "throw ";
+  if (flags & CppExpr::kInitializer)
+    out << "{";
+  if (flags & CppExpr::kBracketed)
+    out << '(';
+  if (flags & CppExpr::kNew)
+    out << "new ";
+  if (flags & CppExpr::kSizeOf)
+    out << "sizeof(";
+  else if (flags & CppExpr::kDelete)
+    out << "delete ";
+  else if (flags & CppExpr::kDeleteArray)
+    out << "delete[] ";
+  if (oper == kNone)
   {
-    emitExprAtom(exprObj->expr1_, stm);
+    emitAtom(0);
   }
-  else if (exprObj->oper_ > kUnariPrefixOperatorStart && exprObj->oper_ < kUnariSufixOperatorStart)
+  else if (oper > kUnariPrefixOperatorStart && oper < kUnariSufixOperatorStart)
   {
-    emitOperator(stm, exprObj->oper_);
-    emitExprAtom(exprObj->expr1_, stm);
+    emitOperator(stm, oper);
+    emitAtom(0);
   }
-  else if (exprObj->oper_ > kUnariSufixOperatorStart && exprObj->oper_ < kBinaryOperatorStart)
+  else if (oper > kUnariSufixOperatorStart && oper < kBinaryOperatorStart)
   {
-    emitExprAtom(exprObj->expr1_, stm);
-    emitOperator(stm, exprObj->oper_);
+    emitAtom(0);
+    emitOperator(stm, oper);
   }
-  else if (exprObj->oper_ > kBinaryOperatorStart && exprObj->oper_ < kDerefOperatorStart)
+  else if (oper > kBinaryOperatorStart && oper < kDerefOperatorStart)
   {
-    emitExprAtom(exprObj->expr1_, stm);
-    if (exprObj->oper_ != kComma)
-      stm << ' ';
-    emitOperator(stm, exprObj->oper_);
-    stm << ' ';
-    emitExprAtom(exprObj->expr2_, stm);
+    emitAtom(0);
+    if (oper != kComma)
+      out << ' ';
+    emitOperator(stm, oper);
+    out << ' ';
+    emitAtom(1);
   }
-  else if (exprObj->oper_ > kDerefOperatorStart && exprObj->oper_ < kSpecialOperations)
+  else if (oper > kDerefOperatorStart && oper < kSpecialOperations)
   {
-    emitExprAtom(exprObj->expr1_, stm);
-    emitOperator(stm, exprObj->oper_);
-    emitExprAtom(exprObj->expr2_, stm);
+    emitAtom(0);
+    emitOperator(stm, oper);
+    emitAtom(1);
   }
-  else if (exprObj->oper_ == kFunctionCall)
+  else if (oper == kFunctionCall)
   {
-    emitExprAtom(exprObj->expr1_, stm);
-    stm << '(';
-    emitExprAtom(exprObj->expr2_, stm);
-    stm << ')';
+    emitAtom(0);
+    out << '(';
+    emitAtom(1);
+    out << ')';
   }
-  else if (exprObj->oper_ == kArrayElem)
+  else if (oper == kArrayElem)
   {
-    emitExprAtom(exprObj->expr1_, stm);
-    stm << '[';
-    emitExprAtom(exprObj->expr2_, stm);
-    stm << ']';
+    emitAtom(0);
+    out << '[';
+    emitAtom(1);
+    out << ']';
   }
-  else if (exprObj->oper_ == kCStyleCast)
+  else if (oper == kCStyleCast)
   {
-    stm << '(';
-    emitExprAtom(exprObj->expr1_, stm);
-    stm << ") ";
-    emitExprAtom(exprObj->expr2_, stm);
+    out << '(';
+    emitAtom(0);
+    out << ") ";
+    emitAtom(1);
   }
-  else if (exprObj->oper_ >= kConstCast && exprObj->oper_ <= kReinterpretCast)
+  else if (oper >= kConstCast && oper <= kReinterpretCast)
   {
-    if (exprObj->oper_ == kConstCast)
-      stm << "const_cast";
-    else if (exprObj->oper_ == kStaticCast)
-      stm << "static_cast";
-    else if (exprObj->oper_ == kDynamicCast)
-      stm << "dynamic_cast";
-    else if (exprObj->oper_ == kReinterpretCast)
-      stm << "reinterpret_cast";
-    stm << '<';
-    emitExprAtom(exprObj->expr1_, stm);
-    stm << ">(";
-    emitExprAtom(exprObj->expr2_, stm);
-    stm << ')';
+    if (oper == kConstCast)
+      out << "const_cast";
+    else if (oper == kStaticCast)
+      out << "static_cast";
+    else if (oper == kDynamicCast)
+      out << "dynamic_cast";
+    else if (oper == kReinterpretCast)
+      out << "reinterpret_cast";
+    out << '<';
+    emitAtom(0);
+    out << ">(";
+    emitAtom(1);
+    out << ')';
   }
-  else if (exprObj->oper_ == kTertiaryOperator)
+  else if (oper == kTertiaryOperator)
   {
-    emitExprAtom(exprObj->expr1_, stm);
-    stm << " ? ";
-    emitExprAtom(exprObj->expr2_, stm);
-    stm << " : ";
-    emitExprAtom(exprObj->expr3_, stm);
+    emitAtom(0);
+    out << " ? ";
+    emitAtom(1);
+    out << " : ";
+    emitAtom(2);
   }
 
-  if (exprObj->flags_ & CppExpr::kBracketed)
-    stm << ')';
-  if (exprObj->flags_ & CppExpr::kInitializer)
-    stm << "}";
-  if (exprObj->flags_ & CppExpr::kSizeOf)
-    stm << ')';
+  if (flags & CppExpr::kBracketed)
+    out << ')';
+  if (flags & CppExpr::kInitializer)
+    out << "}";
+  if (flags & CppExpr::kSizeOf)
+    out << ')';
+}
+
+void CppWriter::emitExpr(const CppExpr* exprObj, std::ostream& stm, CppIndent indentation /*= CppIndent()*/) const
+{
+  CppOutputInserter out(stm);
+
+  if (exprObj == NULL)
+    return;
+  out << indentation;
+  const CppExprAtom* atoms[] = {&exprObj->expr1_, &exprObj->expr2_, &exprObj->expr3_};
+  emitExprImpl(exprObj->flags_, exprObj->oper_, [&](int i) { emitExprAtom(*atoms[i], stm); }, stm);
+}
+
+void CppWriter::emitExpr(const CppExprPool& pool,
+                         CppExprPool::Index idx,
+                         std::ostream&      stm,
+                         CppIndent          indentation /*= CppIndent()*/) const
+{
+  CppOutputInserter out(stm);
+
+  if (idx == CppExprPool::kInvalidIndex)
+    return;
+  out << indentation;
+  const auto& node = pool.node(idx);
+  emitExprImpl(
+    node.flags,
+    node.oper,
+    [&](int i) {
+      const auto& atom = node.atoms[i];
+      switch (atom.type)
+      {
+        case CppExprAtom::kAtom:
+          out << pool.atom(atom.idx);
+          break;
+        case CppExprAtom::kExpr:
+          emitExpr(pool, atom.idx, stm);
+          break;
+        case CppExprAtom::kVarType:
+          emitVarType(pool.varType(atom.idx), stm);
+          break;
+
+        default:
+          break;
+      }
+    },
+    stm);
 }
 
 void CppWriter::emitIfBlock(const CppIfBlock* ifBlock, std::ostream& stm, CppIndent indentation) const
 {
-  stm << indentation;
-  stm << "if (";
+  CppOutputInserter out(stm);
+
+  out << indentation;
+  out << "if (";
   emit(ifBlock->cond_.get(), stm, CppIndent(), true);
-  stm << ")\n";
-  stm << indentation << "{\n";
+  out << ")\n";
+  out << indentation << "{\n";
   ++indentation;
   if (ifBlock->body_)
     emit(ifBlock->body_.get(), stm, indentation);
   --indentation;
-  stm << indentation << "}\n";
+  out << indentation << "}\n";
   if (ifBlock->elsePart())
   {
-    stm << indentation << "else \n";
-    stm << indentation << "{\n";
+    out << indentation << "else \n";
+    out << indentation << "{\n";
     ++indentation;
     emit(ifBlock->elsePart(), stm, indentation);
     --indentation;
-    stm << indentation << "}\n";
+    out << indentation << "}\n";
   }
 }
 
 void CppWriter::emitWhileBlock(const CppWhileBlock* whileBlock, std::ostream& stm, CppIndent indentation) const
 {
-  stm << indentation;
-  stm << "while (";
+  CppOutputInserter out(stm);
+
+  out << indentation;
+  out << "while (";
   emit(whileBlock->cond_.get(), stm, CppIndent(), true);
-  stm << ")\n";
-  stm << indentation << "{\n";
+  out << ")\n";
+  out << indentation << "{\n";
   ++indentation;
   if (whileBlock->body_)
     emit(whileBlock->body_.get(), stm, indentation);
   --indentation;
-  stm << indentation << "}\n";
+  out << indentation << "}\n";
 }
 
 void CppWriter::emitDoBlock(const CppDoWhileBlock* doBlock, std::ostream& stm, CppIndent indentation) const
 {
-  stm << indentation << "do\n";
-  stm << indentation << "{\n";
+  CppOutputInserter out(stm);
+
+  out << indentation << "do\n";
+  out << indentation << "{\n";
   ++indentation;
   if (doBlock->body_)
     emit(doBlock->body_.get(), stm, indentation);
   --indentation;
-  stm << indentation << "} while (";
+  out << indentation << "} while (";
   emit(doBlock->cond_.get(), stm, CppIndent(), true);
-  stm << ");\n";
+  out << ");\n";
 }
 
 void CppWriter::emitForBlock(const CppForBlock* forBlock, std::ostream& stm, CppIndent indentation) const
 {
-  stm << indentation << "for (";
+  CppOutputInserter out(stm);
+
+  out << indentation << "for (";
   if (forBlock->start_.get())
     emit(forBlock->start_.get(), stm, CppIndent(), true);
-  stm << ';';
+  out << ';';
   if (forBlock->stop_)
   {
-    stm << ' ';
+    out << ' ';
     emitExpr(forBlock->stop_.get(), stm);
   }
-  stm << ';';
+  out << ';';
   if (forBlock->step_)
   {
-    stm << ' ';
+    out << ' ';
     emitExpr(forBlock->step_.get(), stm);
   }
-  stm << ")\n";
-  stm << indentation << "{\n";
+  out << ")\n";
+  out << indentation << "{\n";
   ++indentation;
   if (forBlock->body_)
     emit(forBlock->body_.get(), stm, indentation);
   --indentation;
-  stm << indentation << "}\n";
+  out << indentation << "}\n";
 }
 
 void CppWriter::emitSwitchBlock(const CppSwitchBlock* switchBlock, std::ostream& stm, CppIndent indentation) const
 {
-  stm << indentation << "switch(";
+  CppOutputInserter out(stm);
+
+  out << indentation << "switch(";
   emitExpr(switchBlock->cond_.get(), stm);
-  stm << ")\n";
-  stm << indentation++ << "{\n";
+  out << ")\n";
+  out << indentation++ << "{\n";
   for (const auto& caseStmt : *(switchBlock->body_))
   {
     if (caseStmt.case_)
     {
-      stm << indentation++ << "case ";
+      out << indentation++ << "case ";
       emitExpr(caseStmt.case_.get(), stm);
-      stm << ":\n";
+      out << ":\n";
     }
     else
     {
-      stm << "default:\n";
+      out << "default:\n";
     }
     if (caseStmt.body_)
       emitCompound(caseStmt.body_.get(), stm, indentation);
     --indentation;
   }
-  stm << --indentation << "}\n";
+  out << --indentation << "}\n";
+}
+
+std::vector<std::string> CppWriter::emitFiles(const std::vector<CppEmitJob>& jobs,
+                                              unsigned                       numThreads,
+                                              CppTracer*                     tracer) const
+{
+  std::vector<char> failed(jobs.size(), false);
+  runInParallel(jobs.size(), numThreads, [&](size_t i) {
+    const auto&               outputPath = jobs[i].second;
+    boost::system::error_code ec;
+    const auto                outputFolder = boost::filesystem::path(outputPath).parent_path();
+    if (!outputFolder.empty())
+      boost::filesystem::create_directories(outputFolder, ec);
+    CppTraceScope traceEmit(tracer, "emit", outputPath);
+    // Stream is not reused because it carries indentation of preprocessor directives.
+    CppOutputStream stm;
+    emit(jobs[i].first, stm);
+    traceEmit.numBytes(stm.buffer().size());
+    failed[i] = !stm.buffer().writeToFile(outputPath);
+  });
+
+  std::vector<std::string> failedPaths;
+  for (size_t i = 0; i < jobs.size(); ++i)
+  {
+    if (failed[i])
+      failedPaths.push_back(jobs[i].second);
+  }
+  return failedPaths;
 }
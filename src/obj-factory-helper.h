@@ -27,7 +27,7 @@
 #include "cppobjfactory.h"
 #include "cpptoken.h"
 
-extern CppObjFactory* gObjFactory;
+extern const CppObjFactory* gObjFactory;
 
 template <typename... Params>
 CppCompound* newCompound(Params... params)
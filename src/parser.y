@@ -39,7 +39,12 @@
 #include "cppast.h"
 #include "cppvarinit.h"
 #include "parser.tab.h"
+#include "cppdebuglog.h"
 #include "cppobjfactory.h"
+#include "cppparselimits.h"
+#include "cppparserstats.h"
+#include "cppprepro.h"
+#include "cpptracer.h"
 #include "obj-factory-helper.h"
 #include "utils.h"
 
@@ -59,34 +64,77 @@ int GetKeywordId(const std::string& keyword) {
   return (itr != keywordToIdMap.end()) ? itr->second : -1;
 }
 
-#ifndef NDEBUG
-#  define YYDEBUG 1
-#else 
-#  define YYDEBUG 0
-#endif //#ifndef NDEBUG
+// Logs of btyacc are controlled together with our own debug logs and go to the same sink.
+#define YYDEBUG      CPPPARSER_DEBUG_LOG
+#define YYDEBUGPRINT cppDebugLog
 
 #define YYERROR_DETAILED
 
+// Hooks of our btyacc skeleton, see btyaccpa.ske.
+extern CppParserStats* gParserStats;
+extern CppTracer*      gTracer;
+static CppTracer::Clock::time_point gTrialStartTime; // Start of the outermost trial, nested ones are not traced.
+
+static void onTrialStart(bool outermost)
+{
+  if (gParserStats)
+    ++gParserStats->numTrials;
+  if (gTracer && outermost)
+    gTrialStartTime = CppTracer::Clock::now();
+}
+
+// Trial parse is where parser can spend a lot of time without lexing more tokens, so limits are checked there too.
+#define YYTRIALHOOK()       { onTrialStart(!yytrial); if (parseShouldStop(true)) YYABORT; }
+#define YYTRIALENDHOOK()    if (gTracer) gTracer->recordIfSlow("trial", gTrialStartTime)
+#define YYREDUCEHOOK(rule)  if (gParserStats) ++gParserStats->numReductions
+
+// Parsing ends as soon as the lexer hits a limit so that no error recovery messes with values on the stack.
+#define YYREADHOOK()        if (isParseStopped()) YYABORT
+
 #define YYDELETEPOSN(x, y)
 #define YYDELETEVAL(x, y)
 
+extern int yynerrs;
+
+// Values of a trial parse are copies of other values, and after a failed trial parse btyacc recovers from the error
+// with such copies on the stack. So, values are deleted only when parsing is stopped by a limit before any error.
+static bool destroyStackValues()
+{
+  return isParseStopped() && (yynerrs == 0);
+}
+
 #ifndef TRUE // Need this to fix BtYacc compilation error.
 #  define TRUE true
 #endif
 
+#if CPPPARSER_DEBUG_LOG
+
 static int gParseLog = 0;
 
 #define ZZLOG               \
   {                         \
   if (gParseLog)                 \
-    printf("ZZLOG @line#%d, parsing stream line#%d\n", __LINE__, gLineNo); \
+    cppDebugLog("ZZLOG @line#%d, parsing stream line#%d\n", __LINE__, gLineNo); \
 }
 
+#define ZZLOGPREFIX(prefix) \
+  {                         \
+  if (gParseLog)                 \
+    cppDebugLog(prefix);    \
+}
+
+#else // #if CPPPARSER_DEBUG_LOG
+
+// [ZZLOG;] trial actions remain in grammar but do nothing.
+#define ZZLOG               {}
+#define ZZLOGPREFIX(prefix) {}
+
+#endif // #if CPPPARSER_DEBUG_LOG
+
 static int gDisableYyValid = 0;
 
 #define ZZVALID   {         \
-  if (gParseLog)                 \
-    printf("ZZVALID: ");    \
+  ZZLOGPREFIX("ZZVALID: "); \
   ZZLOG;                    \
   if (!gDisableYyValid)     \
     YYVALID;                \
@@ -94,8 +142,7 @@ static int gDisableYyValid = 0;
 
 #define ZZERROR             \
   do {                      \
-    if (gParseLog)               \
-      printf("ZZERROR: ");  \
+    ZZLOGPREFIX("ZZERROR: "); \
     ZZLOG;                  \
     YYERROR;                \
   } while(0)
@@ -143,8 +190,39 @@ static CppCompoundStack             gCompoundStack;
 static CppAccessType                gCurAccessType;
 static std::stack<CppAccessType>    gAccessTypeStack;
 
+// Non-null only while CppParser::parseFileForConfigs() parses all branches of #if at once.
+extern CppPreproNotes* gPreproNotes;
+
 /** {End of Globals} */
 
+static void notePreproDirective(const CppObj* directive)
+{
+  if (!gPreproNotes)
+    return;
+  ++gPreproNotes->numDirectives;
+  if (directive->objType_ != CppObjType::kHashIf)
+    return;
+  switch (static_cast<const CppHashIf*>(directive)->condType_)
+  {
+    case CppHashIf::kIf:
+    case CppHashIf::kIfDef:
+    case CppHashIf::kIfNDef:
+      ++gPreproNotes->condDepth;
+      break;
+    case CppHashIf::kEndIf:
+      --gPreproNotes->condDepth;
+      break;
+    default:
+      break;
+  }
+}
+
+static void noteAccessChange()
+{
+  if (gPreproNotes && (gPreproNotes->condDepth > 0))
+    gPreproNotes->accessChangedInBranch = true;
+}
+
 #define YYPOSN char*
 /**
  * To track the line being parsed so that we can emit precise location of parsing error.
@@ -159,6 +237,13 @@ extern int yylex();
 # pragma GCC diagnostic ignored "-Wwrite-strings"
 #endif
 
+// yydestruct() that btyacc emits right after this takes pos but none of the %destructor uses it.
+// Skeleton pops this right after yydestruct() and the tables that follow it.
+#if defined(__clang__) || defined(__GNUC__)
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
 %}
 
 %union {
@@ -340,6 +425,23 @@ extern int yylex();
 
 %type  <blob>               blob
 
+// Values that are left on the value stack when parsing is stopped by a limit are deleted, see destroyStackValues().
+%destructor { if (destroyStackValues()) delete $$; } <cppObj> <cppEnum> <enumItem> <enumItemList> <fwdDeclObj> <cppVarType>
+%destructor { if (destroyStackValues()) delete $$; } <cppVarObj> <varOrFuncPtr> <asmBlock> <cppVarObjList> <paramList>
+%destructor { if (destroyStackValues()) delete $$; } <typedefName> <typedefList> <usingNamespaceDecl> <namespaceAlias>
+%destructor { if (destroyStackValues()) delete $$; } <usingDecl> <cppCompundObj> <templateParamList> <templateParam>
+%destructor { if (destroyStackValues()) delete $$; } <docCommentObj> <cppExprObj> <cppLambda> <ifBlock> <whileBlock>
+%destructor { if (destroyStackValues()) delete $$; } <doWhileBlock> <forBlock> <forRangeBlock> <switchBlock> <switchBody>
+%destructor { if (destroyStackValues()) delete $$; } <tryBlock> <catchBlock> <cppFuncPointerObj> <cppFuncObj> <cppCtorObj>
+%destructor { if (destroyStackValues()) delete $$; } <cppDtorObj> <cppTypeConverter> <memInitList> <inheritList>
+%destructor { if (destroyStackValues()) delete $$; } <identifierList> <funcThrowSpec> <hashDefine> <hashUndef> <hashInclude>
+%destructor { if (destroyStackValues()) delete $$; } <hashImport> <hashIf> <hashError> <hashPragma> <blob>
+%destructor { if (destroyStackValues()) delete $$.assignValue_; } <cppVarAssign>
+%destructor { if (destroyStackValues()) delete $$.init; } <memInit>
+%destructor { if (destroyStackValues()) delete $$.paramList; } <funcDeclData>
+// Value of progunit is owned by gProgUnit.
+%destructor { } progunit
+
 // precedence as mentioned at https://en.cppreference.com/w/cpp/language/operator_precedence
 %left COMMA
 // &=, ^=, |=, <<=, >>=, *=, /=, %=, +=, -=, =, throw, a?b:c
@@ -433,7 +535,7 @@ stmtlist          : stmt [ZZLOG;] {
                       $$->addMember($2);
                     } // Avoid 'comment-btyacc-constructs.sh' to act on this
                   }
-                  | optstmtlist changeprotlevel [ZZLOG;] { $$ = $1; gCurAccessType = $2; } // Change of protection level is not a statement but this way it is easier to implement.
+                  | optstmtlist changeprotlevel [ZZLOG;] { $$ = $1; gCurAccessType = $2; noteAccessChange(); } // Change of protection level is not a statement but this way it is easier to implement.
                   ;
 
 stmt              : vardeclstmt         [ZZLOG;] { $$ = $1; }
@@ -473,13 +575,14 @@ stmt              : vardeclstmt         [ZZLOG;] { $$ = $1; }
                   | macrocall ';'       [ZZLOG;] { $$ = new CppMacroCall(mergeCppToken($1, $2), gCurAccessType); }
                   | ';'                 [ZZLOG;] { $$ = nullptr; }  /* blank statement */
                   | asmblock            [ZZLOG;] { $$ = $1; }
+                  | blob                [ZZLOG;] { $$ = $1; } /* Inactive branch of #if kept as a placeholder */
                   ;
 
-preprocessor      : define              [ZZLOG;] { $$ = $1; }
-                  | undef               [ZZLOG;] { $$ = $1; }
+preprocessor      : define              [ZZLOG;] { $$ = $1; notePreproDirective($1); }
+                  | undef               [ZZLOG;] { $$ = $1; notePreproDirective($1); }
                   | include             [ZZLOG;] { $$ = $1; }
                   | import              [ZZLOG;] { $$ = $1; }
-                  | hashif              [ZZLOG;] { $$ = $1; }
+                  | hashif              [ZZLOG;] { $$ = $1; notePreproDirective($1); }
                   | hasherror           [ZZLOG;] { $$ = $1; }
                   | pragma              [ZZLOG;] { $$ = $1; }
                   ;
@@ -722,11 +825,11 @@ blob              : tknBlob      [ZZLOG;]   { $$ = new CppBlob($1);         }
 enumitemlist      :                           [ZZLOG;] { $$ = 0; }
                   | enumitemlist enumitem     [ZZLOG;] {
                     $$ = $1 ? $1 : new CppEnumItemList;
-                    $$->push_back($2);
+                    $$->emplace_back($2);
                   }
                   | enumitemlist ',' enumitem [ZZLOG;] {
                     $$ = $1 ? $1 : new CppEnumItemList;
-                    $$->push_back($3);
+                    $$->emplace_back($3);
                   }
                   | enumitemlist ','          [ZZLOG;] {
                     $$ = $1;
@@ -1424,8 +1527,8 @@ ctordecl          : name '(' paramlist ')' %prec CTORDECL
                   ;
 
 meminitlist       :                          [ZZLOG;] { $$ = nullptr; }
-                  | ':' meminit              [ZZLOG;] { $$ = new CppMemInitList; $$->push_back(CppMemInit($2.mem, $2.init)); }
-                  | meminitlist ',' meminit  [ZZLOG;] { $$ = $1; $$->push_back(CppMemInit($3.mem, $3.init)); }
+                  | ':' meminit              [ZZLOG;] { $$ = new CppMemInitList; $$->emplace_back($2.mem, CppExprPtr($2.init)); }
+                  | meminitlist ',' meminit  [ZZLOG;] { $$ = $1; $$->emplace_back($3.mem, CppExprPtr($3.init)); }
                   ;
 
 meminit           : identifier '(' exprorlist ')'    [ZZLOG;] { $$ = CppNtMemInit{$1, $3}; }
@@ -1595,16 +1698,16 @@ optfinal          :          [ZZLOG;] { $$ = 0; }
 
 optinheritlist    :                                                         [ZZLOG;] { $$ = 0; }
                   | ':' protlevel optinherittype typeidentifier                 [ZZVALID;] {
-                    $$ = new CppInheritanceList; $$->push_back(CppInheritInfo((std::string) $4, $2, $3));
+                    $$ = new CppInheritanceList; $$->emplace_back((std::string) $4, $2, $3);
                   }
                   | optinheritlist ',' protlevel optinherittype typeidentifier  [ZZVALID;] {
-                    $$ = $1; $$->push_back(CppInheritInfo((std::string) $5, $3, $4));
+                    $$ = $1; $$->emplace_back((std::string) $5, $3, $4);
                   }
                   | ':' optinherittype protlevel typeidentifier                 [ZZVALID;] {
-                    $$ = new CppInheritanceList; $$->push_back(CppInheritInfo((std::string) $4, $3, $2));
+                    $$ = new CppInheritanceList; $$->emplace_back((std::string) $4, $3, $2);
                   }
                   | optinheritlist ',' optinherittype protlevel typeidentifier  [ZZVALID;] {
-                    $$ = $1; $$->push_back(CppInheritInfo((std::string) $5, $4, $3));
+                    $$ = $1; $$->emplace_back((std::string) $5, $4, $3);
                   }
                   ;
 
@@ -1743,10 +1846,10 @@ strlit            : tknStrLit          [ZZLOG;] { $$ = $1; }
                   | strlit tknStrLit   [ZZLOG;] { $$ = mergeCppToken($1, $2); }
                   ;
 
-expr              : strlit                                                [ZZLOG;] { $$ = new CppExpr((std::string) $1, kNone);          }
-                  | tknCharLit                                            [ZZLOG;] { $$ = new CppExpr((std::string) $1, kNone);          }
-                  | tknNumber                                             [ZZLOG;] { $$ = new CppExpr((std::string) $1, kNone);          }
-                  | '+' tknNumber                                         [ZZLOG;] { $$ = new CppExpr((std::string) $2, kNone);          }
+expr              : strlit                                                [ZZLOG;] { $$ = new CppExpr(CppExprAtom($1.sz, $1.len), kNone);          }
+                  | tknCharLit                                            [ZZLOG;] { $$ = new CppExpr(CppExprAtom($1.sz, $1.len), kNone);          }
+                  | tknNumber                                             [ZZLOG;] { $$ = new CppExpr(CppExprAtom($1.sz, $1.len), kNone);          }
+                  | '+' tknNumber                                         [ZZLOG;] { $$ = new CppExpr(CppExprAtom($2.sz, $2.len), kNone);          }
                   | identifier
                     [
                       if ($1.sz == gParamModPos) {
@@ -1755,7 +1858,7 @@ expr              : strlit                                                [ZZLOG
                       } else {
                         ZZLOG;
                       }
-                    ]                                                     [ZZLOG;] { $$ = new CppExpr((std::string) $1, kNone);          }
+                    ]                                                     [ZZLOG;] { $$ = new CppExpr(CppExprAtom($1.sz, $1.len), kNone);          }
                   | '{' exprlist '}'                                      [ZZLOG;] { $$ = new CppExpr($2, CppExpr::kInitializer);        }
                   | '{' exprlist ',' '}'                                  [ZZLOG;] { $$ = new CppExpr($2, CppExpr::kInitializer);        }
                   | '{' exprorlist '}'                                    [ZZLOG;] { $$ = new CppExpr($2, CppExpr::kInitializer);        }
@@ -1766,7 +1869,7 @@ expr              : strlit                                                [ZZLOG
                   | '!' expr                                              [ZZLOG;] { $$ = new CppExpr($2, kLogNot);                      }
                   | '*' expr %prec DEREF                                  [ZZLOG;] { $$ = new CppExpr($2, kDerefer);                     }
                   | '&' expr %prec ADDRESSOF                              [ZZLOG;] { $$ = new CppExpr($2, kRefer);                       }
-                  | '&' operfuncname %prec ADDRESSOF                          [ZZLOG;] { $$ = new CppExpr(CppExprAtom($2), kRefer);          }
+                  | '&' operfuncname %prec ADDRESSOF                          [ZZLOG;] { $$ = new CppExpr(CppExprAtom($2.sz, $2.len), kRefer);          }
                   | tknInc expr  %prec PREINCR                            [ZZLOG;] { $$ = new CppExpr($2, kPreIncrement);                }
                   | expr tknInc  %prec POSTINCR                           [ZZLOG;] { $$ = new CppExpr($1, kPostIncrement);               }
                   | tknDec expr  %prec PREDECR                            [ZZLOG;] { $$ = new CppExpr($2, kPreDecrement);                }
@@ -1826,25 +1929,25 @@ expr              : strlit                                                [ZZLOG
                       }
                     ]                                                     [ZZLOG;] { $$ = new CppExpr($1, kAnd, $3);                     }
                   | expr tknOr expr                                       [ZZLOG;] { $$ = new CppExpr($1, kOr, $3);                      }
-                  | expr '.' funcname                                     [ZZLOG;] { $$ = new CppExpr($1, kDot, CppExprAtom($3));                     }
-                  | expr tknArrow funcname                                [ZZLOG;] { $$ = new CppExpr($1, kArrow, CppExprAtom($3));      }
-                  | expr tknArrowStar funcname                            [ZZLOG;] { $$ = new CppExpr($1, kArrowStar, CppExprAtom($3));  }
+                  | expr '.' funcname                                     [ZZLOG;] { $$ = new CppExpr($1, kDot, CppExprAtom($3.sz, $3.len));                     }
+                  | expr tknArrow funcname                                [ZZLOG;] { $$ = new CppExpr($1, kArrow, CppExprAtom($3.sz, $3.len));      }
+                  | expr tknArrowStar funcname                            [ZZLOG;] { $$ = new CppExpr($1, kArrowStar, CppExprAtom($3.sz, $3.len));  }
                   | expr '.' '~' funcname                                 [ZZLOG;] { $$ = new CppExpr($1, kDot, CppExprAtom(mergeCppToken($3, $4)));                     }
                   | expr tknArrow '~' funcname                            [ZZLOG;] { $$ = new CppExpr($1, kArrow, CppExprAtom(mergeCppToken($3, $4)));      }
                   | expr '[' expr ']' %prec SUBSCRIPT                     [ZZLOG;] { $$ = new CppExpr($1, kArrayElem, $3);               }
                   | expr '[' ']' %prec SUBSCRIPT                          [ZZLOG;] { $$ = new CppExpr($1, kArrayElem);                   }
                   | expr '(' funcargs ')' %prec FUNCCALL                  [ZZLOG;] { $$ = new CppExpr($1, kFunctionCall, $3);            }
-                  | funcname '(' funcargs ')' %prec FUNCCALL              [ZZLOG;] { $$ = new CppExpr(CppExprAtom($1), kFunctionCall, $3);            }
+                  | funcname '(' funcargs ')' %prec FUNCCALL              [ZZLOG;] { $$ = new CppExpr(CppExprAtom($1.sz, $1.len), kFunctionCall, $3);            }
                   | expr tknArrow '~' identifier '(' ')' %prec FUNCCALL   [ZZLOG;] { $$ = new CppExpr(new CppExpr($1, kArrow, CppExprAtom(mergeCppToken($3, $4))), kFunctionCall, (CppExpr*)nullptr); }
                   /* TODO: Properly support uniform initialization */
-                  | identifier '{' funcargs '}' %prec FUNCCALL            [ZZLOG;] { $$ = new CppExpr(new CppExpr((std::string) $1, kNone), kFunctionCall, $3);            }
+                  | identifier '{' funcargs '}' %prec FUNCCALL            [ZZLOG;] { $$ = new CppExpr(new CppExpr(CppExprAtom($1.sz, $1.len), kNone), kFunctionCall, $3);            }
                   | '(' vartype ')' expr %prec CSTYLECAST                 [ZZLOG;] { $$ = new CppExpr($2, kCStyleCast, $4);              }
                   | tknConstCast tknLT vartype tknGT '(' expr ')'         [ZZLOG;] { $$ = new CppExpr($3, kConstCast, $6);               }
                   | tknStaticCast tknLT vartype tknGT '(' expr ')'        [ZZLOG;] { $$ = new CppExpr($3, kStaticCast, $6);              }
                   | tknDynamicCast tknLT vartype tknGT '(' expr ')'       [ZZLOG;] { $$ = new CppExpr($3, kDynamicCast, $6);             }
                   | tknReinterpretCast tknLT vartype tknGT '(' expr ')'   [ZZLOG;] { $$ = new CppExpr($3, kReinterpretCast, $6);         }
                   | '(' exprorlist ')'                                    [ZZLOG;] { $$ = $2; $2->flags_ |= CppExpr::kBracketed;         }
-                  | tknNew typeidentifier                                 [ZZLOG;] { $$ = new CppExpr((std::string) $2, CppExpr::kNew);  }
+                  | tknNew typeidentifier                                 [ZZLOG;] { $$ = new CppExpr(CppExprAtom($2.sz, $2.len), CppExpr::kNew);  }
                   | tknNew expr                                           [ZZLOG;] { $$ = new CppExpr($2, CppExpr::kNew);  }
                   | tknNew '(' expr ')' expr %prec tknNew                 [ZZLOG;] { $$ = new CppExpr($3, kPlacementNew, $5);            }
                   | tknScopeResOp tknNew '(' expr ')' expr %prec tknNew   [ZZLOG;] { $$ = new CppExpr($4, kPlacementNew, $6);            }
@@ -1862,7 +1965,7 @@ expr              : strlit                                                [ZZLOG
                   | lambda                                                [ZZLOG;] { $$ = new CppExpr($1); }
 
                   /* This is to parse implementation of string user literal, see https://en.cppreference.com/w/cpp/language/user_literal */
-                  | tknNumber name                                          [ZZLOG;] { $$ = new CppExpr((std::string) $1, kNone);          }
+                  | tknNumber name                                          [ZZLOG;] { $$ = new CppExpr(CppExprAtom($1.sz, $1.len), kNone);          }
                   ;
 
 exprlist          : expr ',' expr %prec COMMA                             [ZZLOG;] { $$ = new CppExpr($1, kComma, $3);                   }
@@ -1909,6 +2012,10 @@ void yyerror_detailed  (  char* text,
   extern const char* get_start_of_buffer();
   extern int get_context();
 
+  // Error caused by faked end of input is not an error of input.
+  if (isParseStopped())
+    return;
+
   const char* lineStart = errt_posn;
   const char* buffStart = get_start_of_buffer();
   while(lineStart > buffStart)
@@ -1952,21 +2059,41 @@ enum {
   kYaccLog  = 0x004
 };
 
+#if CPPPARSER_DEBUG_LOG
+
+static bool gDebugLogSet = false;
+
+void setDebugLog(unsigned logFlags)
+{
+  extern int gLexLog;
+
+  gParseLog    = ((logFlags & kParseLog) ? 1 : 0);
+  gLexLog      = ((logFlags & kLexLog)   ? 1 : 0);
+  yydebug      = ((logFlags & kYaccLog)  ? 1 : 0);
+  gDebugLogSet = true;
+}
+
 static void setupEnv()
 {
-#if YYDEBUG
+  // Environment is read only for the first parsing and only if logs were not already set using setDebugLog().
+  if (gDebugLogSet)
+    return;
   const char* yys = getenv("ZZDEBUG");
-  if (yys) {
-    const int yyn = *yys - '0';
-    extern int gLexLog;
+  setDebugLog(yys ? (*yys - '0') : kNoLog);
+}
 
-    gParseLog = ((yyn & kParseLog) ? 1 : 0);
-    gLexLog   = ((yyn & kLexLog)   ? 1 : 0);
-    yydebug   = ((yyn & kYaccLog)  ? 1 : 0);
-  }
-#endif
+#else // #if CPPPARSER_DEBUG_LOG
+
+void setDebugLog(unsigned /* logFlags */)
+{
+}
+
+static void setupEnv()
+{
 }
 
+#endif // #if CPPPARSER_DEBUG_LOG
+
 CppCompoundPtr parseStream(char* stm, size_t stmSize)
 {
   setupEnv();
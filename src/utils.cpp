@@ -141,6 +141,40 @@ std::vector<CppToken> explode(CppToken token, const char* delim)
   return elems;
 }
 
+bool wildcardMatch(const char* pattern, const char* str, size_t len)
+{
+  const char* p       = pattern;
+  const char* star    = nullptr;
+  size_t      starPos = 0;
+  size_t      i       = 0;
+  while (i < len)
+  {
+    if ((*p == '?') || ((*p != '\0') && (*p != '*') && (*p == str[i])))
+    {
+      ++p;
+      ++i;
+    }
+    else if (*p == '*')
+    {
+      star    = p++;
+      starPos = i;
+    }
+    else if (star != nullptr)
+    {
+      p = star + 1;
+      i = ++starPos;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  while (*p == '*')
+    ++p;
+
+  return *p == '\0';
+}
+
 std::string pruneClassName(const CppToken& identifier)
 {
   std::string ret;
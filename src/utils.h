@@ -40,4 +40,7 @@ std::string pruneClassName(const CppToken& identifier);
 
 std::vector<char> readFile(const std::string& filename);
 
-std::vector<CppToken> explode(CppToken token, const char* delim);
\ No newline at end of file
+std::vector<CppToken> explode(CppToken token, const char* delim);
+
+/// @return true if \a str of length \a len matches \a pattern in which '*' matches any sequence and '?' any character.
+bool wildcardMatch(const char* pattern, const char* str, size_t len);
@@ -23,12 +23,25 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <sstream>
+#include <string>
 
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 #include <boost/system/config.hpp>
+#include <boost/utility/string_view.hpp>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
 
 namespace bfs = boost::filesystem;
 namespace bpo = boost::program_options;
@@ -82,6 +95,102 @@ inline std::pair<int, int> compareFiles(std::ifstream& file1, std::ifstream& fil
   return compareContents(buf1.str(), buf2.str());
 }
 
+/**
+ * @return Offset of first byte that differs, or length of the shorter buffer if it is a prefix of the other.
+ */
+inline size_t findFirstDifference(boost::string_view buf1, boost::string_view buf2)
+{
+  const auto   len        = std::min(buf1.size(), buf2.size());
+  const size_t kChunkSize = 256;
+  size_t       pos        = 0;
+  // memcmp() is vectorized and so equal chunks are skipped quickly, only the chunk that differs is scanned by byte.
+  while ((pos + kChunkSize <= len) && (std::memcmp(buf1.data() + pos, buf2.data() + pos, kChunkSize) == 0))
+    pos += kChunkSize;
+  while ((pos < len) && (buf1[pos] == buf2[pos]))
+    ++pos;
+  return pos;
+}
+
+/**
+ * Same as compareContents() but for buffers that need not be std::string.
+ */
+inline std::pair<int, int> compareBuffers(boost::string_view buf1, boost::string_view buf2)
+{
+  const auto diffPos = findFirstDifference(buf1, buf2);
+  if ((diffPos == buf1.size()) && (diffPos == buf2.size()))
+    return std::make_pair(-1, -1);
+  const auto r         = std::count(buf1.data(), buf1.data() + diffPos, '\n');
+  const auto lineStart = buf1.substr(0, diffPos).rfind('\n');
+  const auto c         = (lineStart == boost::string_view::npos) ? diffPos : diffPos - lineStart - 1;
+  return std::make_pair(static_cast<int>(r + 1), static_cast<int>(c + 1));
+}
+
+/**
+ * \brief Read-only view of whole content of a file, memory mapped where possible.
+ */
+class MappedFile
+{
+public:
+  explicit MappedFile(const bfs::path& path)
+  {
+#ifndef _WIN32
+    auto fd = open(path.string().c_str(), O_RDONLY);
+    if (fd < 0)
+      return;
+    struct stat st;
+    if ((fstat(fd, &st) == 0) && S_ISREG(st.st_mode))
+    {
+      isOpen_ = true;
+      size_   = static_cast<size_t>(st.st_size);
+      if (size_ != 0)
+      {
+        auto* mem = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mem != MAP_FAILED)
+          data_ = static_cast<const char*>(mem);
+        else
+          isOpen_ = false;
+      }
+    }
+    close(fd);
+#else
+    std::ifstream file(path.string(), std::ios_base::in | std::ios_base::binary);
+    if (!file.is_open())
+      return;
+    isOpen_ = true;
+    contents_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data_ = contents_.data();
+    size_ = contents_.size();
+#endif
+  }
+  ~MappedFile()
+  {
+#ifndef _WIN32
+    if (data_)
+      munmap(const_cast<char*>(data_), size_);
+#endif
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool isOpen() const
+  {
+    return isOpen_;
+  }
+  boost::string_view contents() const
+  {
+    return boost::string_view(data_ ? data_ : "", size_);
+  }
+
+private:
+  bool        isOpen_ = false;
+  const char* data_   = nullptr;
+  size_t      size_   = 0;
+#ifdef _WIN32
+  std::string contents_;
+#endif
+};
+
 enum FileCompareResult
 {
   kSameFiles,
@@ -105,6 +214,24 @@ inline FileCompareResult compareFiles(const bfs::path& path1, const bfs::path& p
   return kSameFiles;
 }
 
+/**
+ * Compares \a contents with content of file at \a path without writing \a contents anywhere.
+ * \note kFailedToOpen2ndFile is returned if file at \a path cannot be opened.
+ */
+inline FileCompareResult compareWithFile(boost::string_view   contents,
+                                         const bfs::path&     path,
+                                         std::pair<int, int>& diffStartsAt)
+{
+  MappedFile file(path);
+  if (!file.isOpen())
+    return kFailedToOpen2ndFile;
+
+  diffStartsAt = compareBuffers(contents, file.contents());
+  if (diffStartsAt != std::make_pair(-1, -1))
+    return kDifferentFiles;
+  return kSameFiles;
+}
+
 inline void reportFileComparisonError(FileCompareResult    result,
                                       const bfs::path&     path1,
                                       const bfs::path&     path2,
@@ -23,12 +23,30 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "cppparser.h"
 #include "compare.h"
+#include "cppmemoryreport.h"
+#include "cppoutputbuffer.h"
+#include "cppprog.h"
 #include "cppwriter.h"
 #include "options.h"
+#include "test-parser.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <numeric>
+#include <thread>
 #include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#  include <sys/mman.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
 
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
@@ -39,19 +57,175 @@ namespace bpo = boost::program_options;
 
 //////////////////////////////////////////////////////////////////////////
 
-static bool parseAndEmitFormatted(CppParser&       parser,
-                                  const bfs::path& inputFilePath,
-                                  const bfs::path& outputFilePath,
-                                  const CppWriter& cppWriter)
+/// Outcome and timing of testing a single file.
+struct FileTestResult
+{
+  enum Status
+  {
+    kNotTested, ///< Worker process died while testing the file.
+    kPassed,
+    kParsingFailed,
+    kComparisonFailed
+  };
+
+  Status status      = kNotTested;
+  double parseTime   = 0; ///< In seconds.
+  double emitTime    = 0; ///< In seconds.
+  double compareTime = 0; ///< In seconds.
+
+  double totalTime() const
+  {
+    return parseTime + emitTime + compareTime;
+  }
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
 {
-  auto progUnit = parser.parseFile(inputFilePath.string().c_str());
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static FileTestResult testFile(CppParser& parser, const bfs::path& file, const TestParam& params)
+{
+  FileTestResult result;
+  std::cout << "CppParserTest: Parsing " << file.string() << " ...\n";
+  auto      fileRelPath = file.string().substr(params.inputPath.string().length());
+  bfs::path outfile     = params.outputPath / fileRelPath;
+  bfs::remove(outfile);
+
+  auto startTime   = Clock::now();
+  auto progUnit    = parser.parseFile(file.string().c_str());
+  result.parseTime = secondsSince(startTime);
   if (!progUnit)
-    return false;
-  bfs::create_directories(outputFilePath.parent_path());
-  std::ofstream stm(outputFilePath.string());
+  {
+    std::cerr << "Parsing failed for " << file.string() << "\n";
+    result.status = FileTestResult::kParsingFailed;
+    return result;
+  }
+
+  startTime = Clock::now();
+  CppWriter       cppWriter;
+  CppOutputStream stm;
   cppWriter.emit(progUnit.get(), stm);
+  auto writeOutfile = [&]() {
+    bfs::create_directories(outfile.parent_path());
+    return stm.buffer().writeToFile(outfile.string());
+  };
+  if (!params.compareInMemory && !writeOutfile())
+  {
+    std::cerr << "Parsing failed for " << file.string() << "\n";
+    result.status = FileTestResult::kParsingFailed;
+    return result;
+  }
+  result.emitTime = secondsSince(startTime);
 
-  return true;
+  startTime = Clock::now();
+  bfs::path           masfile = params.masterPath / fileRelPath;
+  std::pair<int, int> diffStartInfo;
+  auto                rez = params.compareInMemory ? compareWithFile(stm.buffer().str(), masfile, diffStartInfo)
+                                                   : compareFiles(outfile, masfile, diffStartInfo);
+  result.compareTime      = secondsSince(startTime);
+  if (rez == kSameFiles)
+  {
+    result.status = FileTestResult::kPassed;
+    return result;
+  }
+  // Output is needed only for looking into the failure.
+  if (params.compareInMemory)
+    writeOutfile();
+  reportFileComparisonError(rez, outfile, masfile, diffStartInfo);
+  result.status = FileTestResult::kComparisonFailed;
+  return result;
+}
+
+/**
+ * Tests files in \a numJobs worker processes because parser is not reentrant.
+ * Results are kept in shared memory at index of file and so their order does not depend on scheduling of workers.
+ */
+static std::vector<FileTestResult> testFiles(CppParser&                    parser,
+                                             const std::vector<bfs::path>& files,
+                                             const TestParam&              params)
+{
+  std::vector<FileTestResult> results(files.size());
+  auto                        numJobs = params.numJobs;
+  if (numJobs == 0)
+    numJobs = std::max(std::thread::hardware_concurrency(), 1u);
+  numJobs = std::min<size_t>(numJobs, files.size());
+#ifndef _WIN32
+  if (numJobs > 1)
+  {
+    struct SharedState
+    {
+      std::atomic<size_t> nextFile;
+      FileTestResult      results[1];
+    };
+    const auto sharedSize = sizeof(SharedState) + sizeof(FileTestResult) * files.size();
+    auto*      sharedMem  = mmap(nullptr, sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (sharedMem != MAP_FAILED)
+    {
+      auto* sharedState = static_cast<SharedState*>(sharedMem);
+      new (&sharedState->nextFile) std::atomic<size_t>(0);
+      std::uninitialized_fill_n(sharedState->results, files.size(), FileTestResult());
+
+      std::cout.flush();
+      std::cerr.flush();
+      std::vector<pid_t> workers;
+      for (unsigned i = 0; i < numJobs; ++i)
+      {
+        auto pid = fork();
+        if (pid == 0)
+        {
+          for (size_t f = sharedState->nextFile++; f < files.size(); f = sharedState->nextFile++)
+            sharedState->results[f] = testFile(parser, files[f], params);
+          std::cout.flush();
+          std::cerr.flush();
+          _exit(0);
+        }
+        if (pid > 0)
+          workers.push_back(pid);
+      }
+      for (auto pid : workers)
+        waitpid(pid, nullptr, 0);
+
+      // Files left untested by failed forks are tested here.
+      for (size_t f = sharedState->nextFile++; f < files.size(); f = sharedState->nextFile++)
+        sharedState->results[f] = testFile(parser, files[f], params);
+      std::copy(sharedState->results, sharedState->results + files.size(), results.begin());
+      munmap(sharedMem, sharedSize);
+      return results;
+    }
+  }
+#endif
+  for (size_t f = 0; f < files.size(); ++f)
+    results[f] = testFile(parser, files[f], params);
+  return results;
+}
+
+static void reportSlowestFiles(const std::vector<bfs::path>&      files,
+                               const std::vector<FileTestResult>& results,
+                               size_t                             numSlowest)
+{
+  std::vector<size_t> fileIndices(files.size());
+  std::iota(fileIndices.begin(), fileIndices.end(), 0);
+  numSlowest = std::min(numSlowest, fileIndices.size());
+  if (numSlowest == 0)
+    return;
+  std::partial_sort(
+    fileIndices.begin(), fileIndices.begin() + numSlowest, fileIndices.end(), [&results](size_t lhs, size_t rhs) {
+      return results[lhs].totalTime() > results[rhs].totalTime();
+    });
+
+  std::cout << "\n\nSlowest files (parse, emit, compare and total time in ms).\n------------------------\n";
+  std::cout << std::fixed << std::setprecision(2);
+  for (size_t i = 0; i < numSlowest; ++i)
+  {
+    const auto& result = results[fileIndices[i]];
+    std::cout << std::setw(10) << result.parseTime * 1000 << std::setw(10) << result.emitTime * 1000
+              << std::setw(10) << result.compareTime * 1000 << std::setw(10) << result.totalTime() * 1000 << "  "
+              << files[fileIndices[i]].string() << '\n';
+  }
+  std::cout << std::defaultfloat << '\n';
 }
 
 static bool performParsing(CppParser& parser, const std::string& inputPath)
@@ -65,45 +239,44 @@ static bool performParsing(CppParser& parser, const std::string& inputPath)
 
 static std::pair<size_t, size_t> performTest(CppParser& parser, const TestParam& params)
 {
-  size_t numInputFiles = 0;
-  size_t numFailed     = 0;
+  size_t numFailed = 0;
 
-  using FilePair                        = std::pair<std::string, std::string>;
-  auto                     inputPathLen = params.inputPath.string().length();
+  using FilePair = std::pair<std::string, std::string>;
   std::vector<std::string> parsingFailedFor;
   std::vector<FilePair>    diffFailedList;
 
+  std::vector<bfs::path> files;
   for (bfs::recursive_directory_iterator dirItr(params.inputPath); dirItr != bfs::recursive_directory_iterator();
        ++dirItr)
   {
-    CppWriter cppWriter;
     bfs::path file = *dirItr;
     if (bfs::is_regular_file(file))
+      files.push_back(file);
+  }
+
+  const auto results      = testFiles(parser, files, params);
+  auto       inputPathLen = params.inputPath.string().length();
+  for (size_t i = 0; i < files.size(); ++i)
+  {
+    const auto& result = results[i];
+    if (result.status == FileTestResult::kPassed)
+      continue;
+    ++numFailed;
+    auto filePathStr = files[i].string();
+    if (result.status == FileTestResult::kComparisonFailed)
     {
-      ++numInputFiles;
-      std::cout << "CppParserTest: Parsing " << file.string() << " ...\n";
-      auto      fileRelPath = file.string().substr(inputPathLen);
-      bfs::path outfile     = params.outputPath / fileRelPath;
-      bfs::remove(outfile);
-      if (parseAndEmitFormatted(parser, file, outfile, cppWriter) && bfs::exists(outfile))
-      {
-        bfs::path           masfile = params.masterPath / fileRelPath;
-        std::pair<int, int> diffStartInfo;
-        auto                rez = compareFiles(outfile, masfile, diffStartInfo);
-        if (rez == kSameFiles)
-          continue;
-        reportFileComparisonError(rez, outfile, masfile, diffStartInfo);
-        diffFailedList.emplace_back(std::make_pair(outfile.string(), masfile.string()));
-      }
-      else
-      {
-        auto filePathStr = file.string();
+      auto fileRelPath = filePathStr.substr(inputPathLen);
+      diffFailedList.emplace_back(
+        std::make_pair((params.outputPath / fileRelPath).string(), (params.masterPath / fileRelPath).string()));
+    }
+    else
+    {
+      if (result.status == FileTestResult::kNotTested)
         std::cerr << "Parsing failed for " << filePathStr << "\n";
-        parsingFailedFor.push_back(filePathStr);
-      }
-      ++numFailed;
+      parsingFailedFor.push_back(filePathStr);
     }
   }
+  reportSlowestFiles(files, results, params.numSlowest);
   if (!diffFailedList.empty())
   {
     std::cerr << "\n\n";
@@ -125,123 +298,133 @@ static std::pair<size_t, size_t> performTest(CppParser& parser, const TestParam&
     std::cerr << "Parsing failed for " << parsingFailedFor.size() << " files.\n\n";
   }
 
-  return std::make_pair(numInputFiles, numFailed);
+  return std::make_pair(files.size(), numFailed);
+}
+
+static const char* objTypeName(CppObjType objType)
+{
+  switch (objType)
+  {
+    case CppObjType::kDocComment:
+      return "DocComment";
+    case CppObjType::kHashIf:
+      return "HashIf";
+    case CppObjType::kHashInclude:
+      return "HashInclude";
+    case CppObjType::kHashImport:
+      return "HashImport";
+    case CppObjType::kHashDefine:
+      return "HashDefine";
+    case CppObjType::kHashUndef:
+      return "HashUndef";
+    case CppObjType::kHashPragma:
+      return "HashPragma";
+    case CppObjType::kHashError:
+      return "HashError";
+    case CppObjType::kUnRecogPrePro:
+      return "UnRecogPrePro";
+    case CppObjType::kVarType:
+      return "VarType";
+    case CppObjType::kVar:
+      return "Var";
+    case CppObjType::kVarList:
+      return "VarList";
+    case CppObjType::kTypedefName:
+      return "TypedefName";
+    case CppObjType::kTypedefNameList:
+      return "TypedefNameList";
+    case CppObjType::kNamespaceAlias:
+      return "NamespaceAlias";
+    case CppObjType::kUsingNamespaceDecl:
+      return "UsingNamespaceDecl";
+    case CppObjType::kUsingDecl:
+      return "UsingDecl";
+    case CppObjType::kEnum:
+      return "Enum";
+    case CppObjType::kCompound:
+      return "Compound";
+    case CppObjType::kFwdClsDecl:
+      return "FwdClsDecl";
+    case CppObjType::kFunction:
+      return "Function";
+    case CppObjType::kLambda:
+      return "Lambda";
+    case CppObjType::kConstructor:
+      return "Constructor";
+    case CppObjType::kDestructor:
+      return "Destructor";
+    case CppObjType::kTypeConverter:
+      return "TypeConverter";
+    case CppObjType::kFunctionPtr:
+      return "FunctionPtr";
+    case CppObjType::kExpression:
+      return "Expression";
+    case CppObjType::kMacroCall:
+      return "MacroCall";
+    case CppObjType::kAsmBlock:
+      return "AsmBlock";
+    case CppObjType::kBlob:
+      return "Blob";
+    case CppObjType::kIfBlock:
+      return "IfBlock";
+    case CppObjType::kForBlock:
+      return "ForBlock";
+    case CppObjType::kRangeForBlock:
+      return "RangeForBlock";
+    case CppObjType::kWhileBlock:
+      return "WhileBlock";
+    case CppObjType::kDoWhileBlock:
+      return "DoWhileBlock";
+    case CppObjType::kSwitchBlock:
+      return "SwitchBlock";
+    case CppObjType::kTryBlock:
+      return "TryBlock";
+
+    default:
+      return "Other";
+  }
+}
+
+static void printMemoryUsage(const std::string& name, const CppMemoryUsage& usage)
+{
+  std::cout << std::left << std::setw(48) << name << std::right << std::setw(12) << usage.numObjs << std::setw(16)
+            << usage.numBytes << '\n';
 }
 
-CppParser constructCppParserForTest()
+/// Prints usages in decreasing order of size.
+static void printMemoryUsages(const char* title, const CppMemoryUsageByName& usages)
 {
-  CppParser parser;
-  parser.addKnownApiDecors({"ODRX_ABSTRACT",
-                            "FIRSTDLL_EXPORT",
-                            "GE_DLLEXPIMPORT",
-                            "TOOLKIT_EXPORT",
-
-                            "APIENTRY",
-                            "WINGDIAPI",
-                            "GLUTAPI",
-
-                            "ADESK_NO_VTABLE",
-                            "ACDBCORE2D_PORT",
-                            "ACBASE_PORT",
-                            "ACCORE_PORT",
-                            "ACDB_PORT",
-                            "ACPAL_PORT",
-                            "ACAD_PORT",
-                            "ACPL_PORT",
-                            "ACTCUI_PORT",
-                            "ADESK_DEPRECATED",
-                            "DRAWBRIDGE_API",
-                            "AXAUTOEXP",
-                            "GX_DLLEXPIMPORT",
-                            "ANAV_PORT",
-                            "DRAWBRIDGE_MAC_API",
-                            "ADUI_PORT",
-                            "ACMPOLYGON_PORT",
-                            "ACFDUI_PORT",
-                            "GE_DLLDATAEXIMP",
-                            "ACSYNERGY_PORT",
-                            "ADESK_STDCALL",
-                            "LIGHTDLLIMPEXP",
-                            "SCENEDLLIMPEXP",
-                            "DLLScope",
-
-                            "_CRTIMP",
-
-                            "SKSL_WARN_UNUSED_RESULT",
-                            "SK_ALWAYS_INLINE",
-                            "SK_API",
-                            "SK_BEGIN_REQUIRE_DENSE",
-                            "SK_WARN_UNUSED_RESULT",
-                            "SK_CAPABILITY"});
-
-  parser.addKnownMacros({"DECLARE_MESSAGE_MAP",
-                         "DECLARE_DYNAMIC",
-                         "ACPL_DECLARE_MEMBERS",
-                         "DBSYMUTL_MAKE_GETSYMBOLID_FUNCTION",
-                         "DBSYMUTL_MAKE_HASSYMBOLID_FUNCTION",
-                         "DBSYMUTL_MAKE_HASSYMBOLNAME_FUNCTION",
-                         "ACRX_DECLARE_MEMBERS_EXPIMP",
-                         "ACRX_DECLARE_MEMBERS_ACBASE_PORT_EXPIMP",
-                         "ACRX_DECLARE_MEMBERS",
-                         "DBCURVE_METHODS",
-
-                         "SK_BEGIN_REQUIRE_DENSE",
-                         "SK_END_REQUIRE_DENSE",
-                         "GR_MAKE_BITFIELD_CLASS_OPS",
-                         "SK_C_PLUS_PLUS_BEGIN_GUARD",
-                         "SK_C_PLUS_PLUS_END_GUARD",
-                         "GPU_DRIVER_BUG_WORKAROUNDS",
-                         "GR_MAKE_BITFIELD_OPS",
-                         "SK_FLATTENABLE_HOOKS",
-                         "SK_USE_FLUENT_IMAGE_FILTER_TYPES_IN_CLASS",
-                         "SK_RASTER_PIPELINE_STAGES",
-                         "INTERNAL_DECLARE_SET_TRACE_VALUE_INT",
-                         "INTERNAL_DECLARE_SET_TRACE_VALUE",
-                         "SK_RECORD_TYPES",
-                         "SK_OT_BYTE_BITFIELD",
-                         "SKSL_PRINTF_LIKE",
-                         "ACT_AS_PTR",
-                         "RECORD",
-                         "GR_DECLARE_FRAGMENT_PROCESSOR_TEST",
-                         "GR_DECLARE_GEOMETRY_PROCESSOR_TEST",
-                         "GR_DECLARE_XP_FACTORY_TEST",
-                         "DEFINE_NAMED_APPEND",
-                         "SK_CALLABLE_TRAITS__CV_REF_NE_VARARGS",
-                         "SK_CALLABLE_TRAITS__NE_VARARGS",
-                         "SK_STDMETHODIMP_",
-                         "SK_END_REQUIRE_DENSE",
-                         "GR_DECL_BITFIELD_OPS_FRIENDS",
-                         "SK_PRINTF_LIKE",
-                         "DEFINE_OP_CLASS_ID",
-                         "SHARD",
-                         "SK_WHEN"});
-
-  parser.addIgnorableMacros({"SkDEBUGCODE",
-                             "SkDEBUGPARAMS",
-                             "__bridge",
-                             "__bridge_retained",
-                             "API_AVAILABLE",
-                             "SK_RESTRICT",
-                             "DEBUG_COIN_DECLARE_PARAMS",
-                             "PATH_OPS_DEBUG_T_SECT_CODE",
-                             "PATH_OPS_DEBUG_T_SECT_PARAMS",
-                             "SK_GUARDED_BY",
-                             "SK_ACQUIRE",
-                             "SK_REQUIRES",
-                             "SK_RELEASE_CAPABILITY",
-                             "SK_ASSERT_CAPABILITY",
-                             "SK_ACQUIRE_SHARED",
-                             "SK_RELEASE_SHARED_CAPABILITY",
-                             "SK_BLITBWMASK_ARGS",
-                             "SK_ASSERT_SHARED_CAPABILITY",
-                             
-                             "WXUNUSED"});
-
-  parser.addRenamedKeyword("virtual", "ADESK_SEALED_VIRTUAL");
-  parser.addRenamedKeyword("final", "ADESK_SEALED");
-  parser.addRenamedKeyword("override", "ADESK_OVERRIDE");
-
-  return std::move(parser);
+  std::vector<CppMemoryUsageByName::const_iterator> sorted;
+  for (auto itr = usages.begin(); itr != usages.end(); ++itr)
+    sorted.push_back(itr);
+  std::stable_sort(sorted.begin(), sorted.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs->second.numBytes > rhs->second.numBytes;
+  });
+
+  std::cout << '\n' << title << "\n------------------------\n";
+  for (const auto& itr : sorted)
+    printMemoryUsage(itr->first.empty() ? std::string("<global>") : itr->first, itr->second);
+}
+
+static void performMemoryReport(CppParser parser, const std::string& folder)
+{
+  const CppProgram      program(folder, std::move(parser), selectAllFiles);
+  const CppMemoryReport report(program);
+
+  std::cout << "Memory used by ASTs of " << program.getFileAsts().size() << " files.\n";
+  std::cout << std::left << std::setw(48) << "" << std::right << std::setw(12) << "Objects" << std::setw(16)
+            << "Bytes" << '\n';
+  std::cout << "\nBy object type\n------------------------\n";
+  for (size_t i = 0; i < kNumCppObjTypes; ++i)
+  {
+    const auto& usage = report.byType()[i];
+    if (usage.numObjs != 0)
+      printMemoryUsage(objTypeName(static_cast<CppObjType>(i)), usage);
+  }
+  printMemoryUsage("Total", report.total());
+
+  printMemoryUsages("By top level namespace", report.byNamespace());
+  printMemoryUsages("By file", report.byFile());
 }
 
 int main(int argc, char** argv)
@@ -261,6 +444,10 @@ int main(int argc, char** argv)
     auto filePath = argParser.extractSingleFilePath();
     performParsing(parser, filePath);
   }
+  else if (optionParseResult == ArgParser::kMemoryReport)
+  {
+    performMemoryReport(std::move(parser), argParser.extractMemoryReportFolder());
+  }
   else
   {
     auto params = argParser.extractParamsForFullTest();
@@ -37,6 +37,10 @@ struct TestParam
   fs::path inputPath;
   fs::path outputPath;
   fs::path masterPath;
+  unsigned numJobs         = 1;  ///< Number of worker processes that test files.
+  unsigned numSlowest      = 10; ///< Number of slowest files to report.
+  /// Compare emitted source in memory with master file, output file is written only when comparison fails.
+  bool     compareInMemory = false;
 
   bool isValid() const
   {
@@ -68,6 +72,7 @@ public:
   {
     kHelpSought,
     kParseSingleFile,
+    kMemoryReport,
     kParseAndCompare,
     kParseAndCompareUsingDefaultPaths = kParseAndCompare,
     kParsingError
@@ -86,7 +91,14 @@ public:
       "master-files-folder,m",
       bpo::value<std::string>(),
       "Folder where master files are kept that are used to compare with actuals.")(
-      "parse-single-file,p", bpo::value<std::string>(), "To test parsing of single file.");
+      "parse-single-file,p", bpo::value<std::string>(), "To test parsing of single file.")(
+      "jobs,j", bpo::value<unsigned>(), "Number of worker processes to test files in parallel, 0 means one per core.")(
+      "slowest,s", bpo::value<unsigned>(), "Number of slowest files to report, 10 by default.")(
+      "compare-in-memory",
+      "Compare emitted source with master file without writing it, output file is written only for failed tests.")(
+      "memory-report,r",
+      bpo::value<std::string>(),
+      "Parse all files of a folder and report memory used by their ASTs by object type, file, and namespace.");
   }
 
   ParseResult parse(int argc, char** argv)
@@ -102,6 +114,8 @@ public:
 
     if (vm_.count("parse-single-file") != 0)
       return kParseSingleFile;
+    if (vm_.count("memory-report") != 0)
+      return kMemoryReport;
     if ((vm_.count("input-folder") == 0) && (vm_.count("output-folder") == 0)
         && (vm_.count("master-files-folder") == 0))
       return kParseAndCompareUsingDefaultPaths;
@@ -128,6 +142,11 @@ public:
       param.masterPath = vm_["master-files-folder"].as<std::string>();
     else
       param.masterPath = defaultTestFolderParent / "test_master";
+    if (vm_.count("jobs"))
+      param.numJobs = vm_["jobs"].as<unsigned>();
+    if (vm_.count("slowest"))
+      param.numSlowest = vm_["slowest"].as<unsigned>();
+    param.compareInMemory = (vm_.count("compare-in-memory") != 0);
 
     param.setup();
     return param;
@@ -138,6 +157,11 @@ public:
     return vm_["parse-single-file"].as<std::string>();
   }
 
+  std::string extractMemoryReportFolder() const
+  {
+    return vm_["memory-report"].as<std::string>();
+  }
+
   void emitError() const
   {
     if (vm_.count("help"))
@@ -0,0 +1,145 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2014
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "cppparser.h"
+
+/**
+ * @return Parser configured for the files in e2e test.
+ */
+inline CppParser constructCppParserForTest()
+{
+  CppParser parser;
+  parser.addKnownApiDecors({"ODRX_ABSTRACT",
+                            "FIRSTDLL_EXPORT",
+                            "GE_DLLEXPIMPORT",
+                            "TOOLKIT_EXPORT",
+
+                            "APIENTRY",
+                            "WINGDIAPI",
+                            "GLUTAPI",
+
+                            "ADESK_NO_VTABLE",
+                            "ACDBCORE2D_PORT",
+                            "ACBASE_PORT",
+                            "ACCORE_PORT",
+                            "ACDB_PORT",
+                            "ACPAL_PORT",
+                            "ACAD_PORT",
+                            "ACPL_PORT",
+                            "ACTCUI_PORT",
+                            "ADESK_DEPRECATED",
+                            "DRAWBRIDGE_API",
+                            "AXAUTOEXP",
+                            "GX_DLLEXPIMPORT",
+                            "ANAV_PORT",
+                            "DRAWBRIDGE_MAC_API",
+                            "ADUI_PORT",
+                            "ACMPOLYGON_PORT",
+                            "ACFDUI_PORT",
+                            "GE_DLLDATAEXIMP",
+                            "ACSYNERGY_PORT",
+                            "ADESK_STDCALL",
+                            "LIGHTDLLIMPEXP",
+                            "SCENEDLLIMPEXP",
+                            "DLLScope",
+
+                            "_CRTIMP",
+
+                            "SKSL_WARN_UNUSED_RESULT",
+                            "SK_ALWAYS_INLINE",
+                            "SK_API",
+                            "SK_BEGIN_REQUIRE_DENSE",
+                            "SK_WARN_UNUSED_RESULT",
+                            "SK_CAPABILITY"});
+
+  parser.addKnownMacros({"DECLARE_MESSAGE_MAP",
+                         "DECLARE_DYNAMIC",
+                         "ACPL_DECLARE_MEMBERS",
+                         "DBSYMUTL_MAKE_GETSYMBOLID_FUNCTION",
+                         "DBSYMUTL_MAKE_HASSYMBOLID_FUNCTION",
+                         "DBSYMUTL_MAKE_HASSYMBOLNAME_FUNCTION",
+                         "ACRX_DECLARE_MEMBERS_EXPIMP",
+                         "ACRX_DECLARE_MEMBERS_ACBASE_PORT_EXPIMP",
+                         "ACRX_DECLARE_MEMBERS",
+                         "DBCURVE_METHODS",
+
+                         "SK_BEGIN_REQUIRE_DENSE",
+                         "SK_END_REQUIRE_DENSE",
+                         "GR_MAKE_BITFIELD_CLASS_OPS",
+                         "SK_C_PLUS_PLUS_BEGIN_GUARD",
+                         "SK_C_PLUS_PLUS_END_GUARD",
+                         "GPU_DRIVER_BUG_WORKAROUNDS",
+                         "GR_MAKE_BITFIELD_OPS",
+                         "SK_FLATTENABLE_HOOKS",
+                         "SK_USE_FLUENT_IMAGE_FILTER_TYPES_IN_CLASS",
+                         "SK_RASTER_PIPELINE_STAGES",
+                         "INTERNAL_DECLARE_SET_TRACE_VALUE_INT",
+                         "INTERNAL_DECLARE_SET_TRACE_VALUE",
+                         "SK_RECORD_TYPES",
+                         "SK_OT_BYTE_BITFIELD",
+                         "SKSL_PRINTF_LIKE",
+                         "ACT_AS_PTR",
+                         "RECORD",
+                         "GR_DECLARE_FRAGMENT_PROCESSOR_TEST",
+                         "GR_DECLARE_GEOMETRY_PROCESSOR_TEST",
+                         "GR_DECLARE_XP_FACTORY_TEST",
+                         "DEFINE_NAMED_APPEND",
+                         "SK_CALLABLE_TRAITS__CV_REF_NE_VARARGS",
+                         "SK_CALLABLE_TRAITS__NE_VARARGS",
+                         "SK_STDMETHODIMP_",
+                         "SK_END_REQUIRE_DENSE",
+                         "GR_DECL_BITFIELD_OPS_FRIENDS",
+                         "SK_PRINTF_LIKE",
+                         "DEFINE_OP_CLASS_ID",
+                         "SHARD",
+                         "SK_WHEN"});
+
+  parser.addIgnorableMacros({"SkDEBUGCODE",
+                             "SkDEBUGPARAMS",
+                             "__bridge",
+                             "__bridge_retained",
+                             "API_AVAILABLE",
+                             "SK_RESTRICT",
+                             "DEBUG_COIN_DECLARE_PARAMS",
+                             "PATH_OPS_DEBUG_T_SECT_CODE",
+                             "PATH_OPS_DEBUG_T_SECT_PARAMS",
+                             "SK_GUARDED_BY",
+                             "SK_ACQUIRE",
+                             "SK_REQUIRES",
+                             "SK_RELEASE_CAPABILITY",
+                             "SK_ASSERT_CAPABILITY",
+                             "SK_ACQUIRE_SHARED",
+                             "SK_RELEASE_SHARED_CAPABILITY",
+                             "SK_BLITBWMASK_ARGS",
+                             "SK_ASSERT_SHARED_CAPABILITY",
+                             
+                             "WXUNUSED"});
+
+  parser.addRenamedKeyword("virtual", "ADESK_SEALED_VIRTUAL");
+  parser.addRenamedKeyword("final", "ADESK_SEALED");
+  parser.addRenamedKeyword("override", "ADESK_OVERRIDE");
+
+  return std::move(parser);
+}
@@ -0,0 +1,378 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2014
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Benchmark of parsing the e2e corpus, phase by phase, with results in JSON and comparison against a baseline.
+
+#include "cppoutputbuffer.h"
+#include "cppparser.h"
+#include "cppprog.h"
+#include "cppwriter.h"
+
+#include "../app/test-parser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#ifndef _WIN32
+#  include <sys/resource.h>
+#endif
+
+namespace bfs = boost::filesystem;
+namespace bpo = boost::program_options;
+
+// Lexer is not part of public API but lexing alone has to be timed.
+void setupScanBuffer(char* buf, size_t bufsize);
+void cleanupScanBuffer();
+int  yylex();
+
+//////////////////////////////////////////////////////////////////////////
+
+enum Phase
+{
+  kRead,
+  kLex,
+  kParse,
+  kTypeTree,
+  kEmit,
+  kNumPhases
+};
+
+static const char* const kPhaseNames[kNumPhases] = {"read", "lex", "parse", "typetree", "emit"};
+
+// Subset of inputs found by cppparserfuzzer to be slow, which are kept out of "all".
+static const char* const kRegressionSubset = "slow_inputs";
+
+struct FileTiming
+{
+  bfs::path path;
+  bfs::path relPath;
+  size_t    size                = 0;
+  bool      parsed              = false;
+  double    seconds[kNumPhases] = {}; ///< Best of all repetitions.
+};
+
+struct PhaseSummary
+{
+  size_t bytes        = 0;
+  double totalSeconds = 0;
+  double mbPerSec     = 0;
+  double p50Ms        = 0;
+  double p90Ms        = 0;
+  double p99Ms        = 0;
+  double maxMs        = 0;
+};
+
+struct SubsetSummary
+{
+  size_t       numFiles  = 0;
+  size_t       numFailed = 0;
+  size_t       bytes     = 0;
+  PhaseSummary phases[kNumPhases];
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Same as what CppParser::parseFile() does before parsing.
+static std::vector<char> readFile(const bfs::path& path)
+{
+  std::ifstream     in(path.string(), std::ios::in | std::ios::binary);
+  std::vector<char> contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  contents.erase(std::remove(contents.begin(), contents.end(), '\r'), contents.end());
+  contents.push_back('\n');
+  contents.push_back('\0');
+  contents.push_back('\0');
+  return contents;
+}
+
+static void timeFile(CppParser& parser, FileTiming& timing, bool firstRun)
+{
+  const auto& path = timing.path;
+  auto updateTiming = [&](Phase phase, double seconds) {
+    timing.seconds[phase] = firstRun ? seconds : std::min(timing.seconds[phase], seconds);
+  };
+
+  auto startTime = Clock::now();
+  auto contents  = readFile(path);
+  updateTiming(kRead, secondsSince(startTime));
+  timing.size = contents.size() - 3;
+
+  auto lexBuffer = contents;
+  startTime      = Clock::now();
+  setupScanBuffer(lexBuffer.data(), lexBuffer.size());
+  while (yylex())
+    ;
+  cleanupScanBuffer();
+  updateTiming(kLex, secondsSince(startTime));
+
+  startTime   = Clock::now();
+  auto cppAst = parser.parseStream(contents.data(), contents.size());
+  updateTiming(kParse, secondsSince(startTime));
+  timing.parsed = (cppAst != nullptr);
+  if (!cppAst)
+    return;
+  cppAst->name(path.string());
+
+  CppOutputStream stm;
+  startTime = Clock::now();
+  CppWriter().emit(cppAst.get(), stm);
+  updateTiming(kEmit, secondsSince(startTime));
+
+  CppProgram program(std::vector<std::string>{});
+  startTime = Clock::now();
+  program.addCppAst(std::move(cppAst));
+  updateTiming(kTypeTree, secondsSince(startTime));
+}
+
+static double percentile(const std::vector<double>& sortedValues, double p)
+{
+  if (sortedValues.empty())
+    return 0;
+  const auto idx = static_cast<size_t>(p * (sortedValues.size() - 1) + 0.5);
+  return sortedValues[std::min(idx, sortedValues.size() - 1)];
+}
+
+static SubsetSummary summarize(const std::vector<FileTiming>& timings, const std::string& subset)
+{
+  SubsetSummary       summary;
+  std::vector<double> latencies[kNumPhases];
+  for (const auto& timing : timings)
+  {
+    const auto timingSubset = timing.relPath.begin()->string();
+    if (subset.empty() ? (timingSubset == kRegressionSubset) : (timingSubset != subset))
+      continue;
+    ++summary.numFiles;
+    summary.bytes += timing.size;
+    if (!timing.parsed)
+      ++summary.numFailed;
+    for (int phase = 0; phase < kNumPhases; ++phase)
+    {
+      // Files that failed to parse never reach later phases.
+      if (!timing.parsed && (phase == kTypeTree || phase == kEmit))
+        continue;
+      summary.phases[phase].bytes += timing.size;
+      summary.phases[phase].totalSeconds += timing.seconds[phase];
+      latencies[phase].push_back(timing.seconds[phase] * 1000);
+    }
+  }
+  for (int phase = 0; phase < kNumPhases; ++phase)
+  {
+    auto& phaseSummary = summary.phases[phase];
+    auto& values       = latencies[phase];
+    std::sort(values.begin(), values.end());
+    if (phaseSummary.totalSeconds > 0)
+      phaseSummary.mbPerSec = phaseSummary.bytes / (1024.0 * 1024.0) / phaseSummary.totalSeconds;
+    phaseSummary.p50Ms = percentile(values, 0.50);
+    phaseSummary.p90Ms = percentile(values, 0.90);
+    phaseSummary.p99Ms = percentile(values, 0.99);
+    phaseSummary.maxMs = values.empty() ? 0 : values.back();
+  }
+  return summary;
+}
+
+static long peakRssKb()
+{
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    return usage.ru_maxrss;
+#endif
+  return 0;
+}
+
+static void writeJson(std::ostream& stm, const std::map<std::string, SubsetSummary>& summaries)
+{
+  stm << "{\n  \"peakRssKb\": " << peakRssKb() << ",\n  \"subsets\": {";
+  const char* subsetSep = "\n";
+  for (const auto& subsetAndSummary : summaries)
+  {
+    const auto& summary = subsetAndSummary.second;
+    stm << subsetSep << "    \"" << subsetAndSummary.first << "\": {\n";
+    stm << "      \"files\": " << summary.numFiles << ",\n";
+    stm << "      \"failed\": " << summary.numFailed << ",\n";
+    stm << "      \"bytes\": " << summary.bytes << ",\n";
+    stm << "      \"phases\": {";
+    const char* phaseSep = "\n";
+    for (int phase = 0; phase < kNumPhases; ++phase)
+    {
+      const auto& phaseSummary = summary.phases[phase];
+      stm << phaseSep << "        \"" << kPhaseNames[phase] << "\": {";
+      stm << "\"seconds\": " << phaseSummary.totalSeconds << ", \"mbPerSec\": " << phaseSummary.mbPerSec
+          << ", \"p50Ms\": " << phaseSummary.p50Ms << ", \"p90Ms\": " << phaseSummary.p90Ms
+          << ", \"p99Ms\": " << phaseSummary.p99Ms << ", \"maxMs\": " << phaseSummary.maxMs << "}";
+      phaseSep = ",\n";
+    }
+    stm << "\n      }\n    }";
+    subsetSep = ",\n";
+  }
+  stm << "\n  }\n}\n";
+}
+
+/**
+ * Compares throughput of each phase with that in baseline.
+ * @return Number of phases whose throughput dropped by more than \a thresholdPercent.
+ */
+static int compareWithBaseline(const std::map<std::string, SubsetSummary>& summaries,
+                               const std::string&                          baselinePath,
+                               double                                      thresholdPercent)
+{
+  boost::property_tree::ptree baseline;
+  boost::property_tree::read_json(baselinePath, baseline);
+
+  int numRegressions = 0;
+  for (const auto& subsetAndSummary : summaries)
+  {
+    for (int phase = 0; phase < kNumPhases; ++phase)
+    {
+      // '/' is used as separator of path because subset is a folder name that can contain '.'.
+      const auto key = "subsets/" + subsetAndSummary.first + "/phases/" + kPhaseNames[phase] + "/mbPerSec";
+      auto       baseRate = baseline.get_optional<double>(boost::property_tree::ptree::path_type(key, '/'));
+      if (!baseRate || (*baseRate <= 0))
+        continue;
+      const auto rate   = subsetAndSummary.second.phases[phase].mbPerSec;
+      const auto change = (rate - *baseRate) * 100 / *baseRate;
+      if (change < -thresholdPercent)
+      {
+        std::cerr << "REGRESSION\t" << subsetAndSummary.first << '/' << kPhaseNames[phase] << ": " << rate
+                  << " MB/s against baseline of " << *baseRate << " MB/s (" << change << "%)\n";
+        ++numRegressions;
+      }
+    }
+  }
+  return numRegressions;
+}
+
+int main(int argc, char** argv)
+{
+  const auto testPath                = bfs::path(__FILE__).parent_path().parent_path();
+  const auto defaultInputPath        = testPath / "e2e" / "test_input";
+  const auto defaultRegressionCorpus = testPath / "fuzz" / kRegressionSubset;
+
+  bpo::options_description desc("Benchmark of parsing files, phase by phase");
+  desc.add_options()("help,h", "produce help message")(
+    "input-folder,i", bpo::value<std::string>(), "Folder of files to parse, e2e test input by default.")(
+    "subset,s",
+    bpo::value<std::vector<std::string>>(),
+    "Top level folder of input to report separately, can be repeated. Default: skia, wxWidgets, ObjectArxHeaders.")(
+    "regression-corpus,c",
+    bpo::value<std::string>(),
+    "Folder of inputs found slow by cppparserfuzzer, reported as subset slow_inputs. Default: test/fuzz/slow_inputs.")(
+    "repeat,r", bpo::value<unsigned>()->default_value(1), "Number of times each file is processed, best time is kept.")(
+    "output,o", bpo::value<std::string>(), "File to write JSON result to, standard output by default.")(
+    "baseline,b", bpo::value<std::string>(), "JSON result of an earlier run to compare against.")(
+    "threshold,t",
+    bpo::value<double>()->default_value(10),
+    "Percentage drop of throughput of a phase from baseline that is considered a regression.");
+
+  bpo::variables_map vm;
+  bpo::store(bpo::parse_command_line(argc, argv, desc), vm);
+  bpo::notify(vm);
+  if (vm.count("help"))
+  {
+    std::cout << desc << "\n";
+    return 0;
+  }
+
+  const auto inputPath =
+    vm.count("input-folder") ? bfs::path(vm["input-folder"].as<std::string>()) : defaultInputPath;
+  const auto subsets    = vm.count("subset") ? vm["subset"].as<std::vector<std::string>>()
+                                             : std::vector<std::string>{"skia", "wxWidgets", "ObjectArxHeaders"};
+  const auto regressionCorpus =
+    vm.count("regression-corpus") ? bfs::path(vm["regression-corpus"].as<std::string>()) : defaultRegressionCorpus;
+  const auto numRepeats = std::max(vm["repeat"].as<unsigned>(), 1u);
+
+  std::vector<FileTiming> timings;
+  auto                    collectFiles = [&timings](const bfs::path& folder, const bfs::path& relFolder) {
+    for (bfs::recursive_directory_iterator dirItr(folder); dirItr != bfs::recursive_directory_iterator(); ++dirItr)
+    {
+      if (!bfs::is_regular_file(dirItr->path()))
+        continue;
+      FileTiming timing;
+      timing.path    = dirItr->path();
+      timing.relPath = relFolder / dirItr->path().lexically_relative(folder);
+      timings.push_back(timing);
+    }
+  };
+  collectFiles(inputPath, bfs::path());
+  if (bfs::is_directory(regressionCorpus))
+    collectFiles(regressionCorpus, kRegressionSubset);
+  // Same order in every run keeps caches and allocator state comparable.
+  std::sort(timings.begin(), timings.end(), [](const FileTiming& lhs, const FileTiming& rhs) {
+    return lhs.relPath < rhs.relPath;
+  });
+
+  CppParser parser = constructCppParserForTest();
+  parser.parseEnumBodyAsBlob();
+  for (unsigned run = 0; run < numRepeats; ++run)
+  {
+    for (auto& timing : timings)
+      timeFile(parser, timing, run == 0);
+  }
+
+  std::map<std::string, SubsetSummary> summaries;
+  summaries["all"] = summarize(timings, std::string());
+  for (const auto& subset : subsets)
+  {
+    if (subset == kRegressionSubset)
+      continue;
+    auto summary = summarize(timings, subset);
+    if (summary.numFiles)
+      summaries[subset] = summary;
+  }
+  auto regressionSummary = summarize(timings, kRegressionSubset);
+  if (regressionSummary.numFiles)
+    summaries[kRegressionSubset] = regressionSummary;
+
+  if (vm.count("output"))
+  {
+    std::ofstream out(vm["output"].as<std::string>());
+    writeJson(out, summaries);
+  }
+  else
+  {
+    writeJson(std::cout, summaries);
+  }
+
+  if (vm.count("baseline")
+      && compareWithBaseline(summaries, vm["baseline"].as<std::string>(), vm["threshold"].as<double>()))
+  {
+    return 1;
+  }
+
+  return 0;
+}
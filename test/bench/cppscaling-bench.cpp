@@ -0,0 +1,382 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2014
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Benchmark of how time and memory of parsing, emitting, and destroying an AST grow with size of synthetic inputs.
+// Growth of each is fitted to a power curve c*N^k so that superlinear behaviour shows up as exponent k above 1.
+
+#include "cppmemoryreport.h"
+#include "cppoutputbuffer.h"
+#include "cppparser.h"
+#include "cppwriter.h"
+#include "scaling-inputs.h"
+
+#include "../app/test-parser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+namespace bpo = boost::program_options;
+
+//////////////////////////////////////////////////////////////////////////
+
+// Every allocation of the process is counted to know how memory used while parsing grows.
+static std::atomic<size_t> gNumAllocs{0};
+static std::atomic<size_t> gAllocatedBytes{0};
+
+void* operator new(size_t size)
+{
+  gNumAllocs.fetch_add(1, std::memory_order_relaxed);
+  gAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  if (auto* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+  std::free(p);
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+enum Metric
+{
+  kParseTime,
+  kEmitTime,
+  kDestroyTime,
+  kParseAllocs,
+  kParseAllocatedBytes,
+  kAstBytes,
+  kNumMetrics
+};
+
+static const char* const kMetricNames[kNumMetrics] = {
+  "parseSeconds", "emitSeconds", "destroySeconds", "parseAllocs", "parseAllocatedBytes", "astBytes"};
+
+static bool isTimeMetric(int metric)
+{
+  return metric <= kDestroyTime;
+}
+
+struct ScalingPoint
+{
+  size_t n      = 0;
+  size_t size   = 0; ///< Size of input in bytes.
+  bool   parsed = false;
+  double values[kNumMetrics] = {}; ///< Times are best of all repetitions.
+};
+
+/// Power curve value = coefficient * n^exponent.
+struct GrowthFit
+{
+  bool   valid       = false;
+  double exponent    = 0;
+  double coefficient = 0;
+};
+
+struct ShapeResult
+{
+  ScalingShape              shape;
+  std::vector<ScalingPoint> points;
+  GrowthFit                 fits[kNumMetrics];
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static ScalingPoint measure(CppParser& parser, ScalingShape shape, size_t n, unsigned numRepeats)
+{
+  ScalingPoint point;
+  point.n          = n;
+  const auto input = generateScalingInput(shape, n);
+  point.size       = input.size();
+
+  for (unsigned run = 0; run < numRepeats; ++run)
+  {
+    // Same layout of buffer as what CppParser::parseFile() passes to parser.
+    std::vector<char> contents(input.begin(), input.end());
+    contents.push_back('\n');
+    contents.push_back('\0');
+    contents.push_back('\0');
+
+    const auto numAllocsOrig      = gNumAllocs.load();
+    const auto allocatedBytesOrig = gAllocatedBytes.load();
+    auto       startTime          = Clock::now();
+    auto       cppAst             = parser.parseStream(contents.data(), contents.size());
+    const auto parseTime          = secondsSince(startTime);
+    const auto numAllocs          = gNumAllocs.load() - numAllocsOrig;
+    const auto allocatedBytes     = gAllocatedBytes.load() - allocatedBytesOrig;
+    point.parsed                  = (cppAst != nullptr);
+    if (!cppAst)
+      return point;
+
+    CppOutputStream stm;
+    startTime           = Clock::now();
+    CppWriter().emit(cppAst.get(), stm);
+    const auto emitTime = secondsSince(startTime);
+
+    const auto astBytes = CppMemoryReport(cppAst.get()).total().numBytes;
+
+    startTime = Clock::now();
+    cppAst.reset();
+    const auto destroyTime = secondsSince(startTime);
+
+    const double values[kNumMetrics] = {parseTime,
+                                        emitTime,
+                                        destroyTime,
+                                        static_cast<double>(numAllocs),
+                                        static_cast<double>(allocatedBytes),
+                                        static_cast<double>(astBytes)};
+    for (int metric = 0; metric < kNumMetrics; ++metric)
+    {
+      if ((run == 0) || !isTimeMetric(metric))
+        point.values[metric] = values[metric];
+      else
+        point.values[metric] = std::min(point.values[metric], values[metric]);
+    }
+  }
+
+  return point;
+}
+
+/**
+ * Least square fit of log(value) against log(n).
+ * Values below \a minValue are left out because timer resolution and noise dominate them.
+ */
+static GrowthFit fitGrowth(const std::vector<ScalingPoint>& points, int metric, double minValue)
+{
+  double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+  size_t numPoints = 0;
+  for (const auto& point : points)
+  {
+    if (!point.parsed || (point.values[metric] < minValue) || (point.values[metric] <= 0))
+      continue;
+    const auto x = std::log(static_cast<double>(point.n));
+    const auto y = std::log(point.values[metric]);
+    sumX += x;
+    sumY += y;
+    sumXX += x * x;
+    sumXY += x * y;
+    ++numPoints;
+  }
+
+  GrowthFit fit;
+  const auto denominator = numPoints * sumXX - sumX * sumX;
+  if ((numPoints < 3) || (denominator <= 0))
+    return fit;
+  fit.valid       = true;
+  fit.exponent    = (numPoints * sumXY - sumX * sumY) / denominator;
+  fit.coefficient = std::exp((sumY - fit.exponent * sumX) / numPoints);
+  return fit;
+}
+
+static void printResult(const ShapeResult& result)
+{
+  std::cout << '\n' << kScalingShapeNames[result.shape] << "\n------------------------\n";
+  std::cout << std::setw(8) << "N" << std::setw(12) << "bytes" << std::setw(12) << "parse ms" << std::setw(12)
+            << "emit ms" << std::setw(12) << "destroy ms" << std::setw(12) << "allocs" << std::setw(14)
+            << "alloc bytes" << std::setw(12) << "AST bytes" << '\n';
+  for (const auto& point : result.points)
+  {
+    std::cout << std::setw(8) << point.n << std::setw(12) << point.size;
+    if (!point.parsed)
+    {
+      std::cout << "  parsing failed\n";
+      continue;
+    }
+    std::cout << std::fixed << std::setprecision(3);
+    for (int metric = 0; metric < kNumMetrics; ++metric)
+    {
+      if (isTimeMetric(metric))
+        std::cout << std::setw(12) << point.values[metric] * 1000;
+      else
+        std::cout << std::setw(metric == kParseAllocatedBytes ? 14 : 12) << static_cast<size_t>(point.values[metric]);
+    }
+    std::cout << std::defaultfloat << '\n';
+  }
+  std::cout << "Growth exponents:";
+  for (int metric = 0; metric < kNumMetrics; ++metric)
+  {
+    const auto& fit = result.fits[metric];
+    std::cout << ' ' << kMetricNames[metric] << '=';
+    if (fit.valid)
+      std::cout << std::fixed << std::setprecision(2) << fit.exponent << std::defaultfloat;
+    else
+      std::cout << '-';
+  }
+  std::cout << '\n';
+}
+
+static void writeJson(std::ostream& stm, const std::vector<ShapeResult>& results)
+{
+  stm << "{\n  \"shapes\": {";
+  const char* shapeSep = "\n";
+  for (const auto& result : results)
+  {
+    stm << shapeSep << "    \"" << kScalingShapeNames[result.shape] << "\": {\n      \"fits\": {";
+    const char* fitSep = "\n";
+    for (int metric = 0; metric < kNumMetrics; ++metric)
+    {
+      const auto& fit = result.fits[metric];
+      if (!fit.valid)
+        continue;
+      stm << fitSep << "        \"" << kMetricNames[metric] << "\": {\"exponent\": " << fit.exponent
+          << ", \"coefficient\": " << fit.coefficient << "}";
+      fitSep = ",\n";
+    }
+    stm << "\n      },\n      \"points\": [";
+    const char* pointSep = "\n";
+    for (const auto& point : result.points)
+    {
+      stm << pointSep << "        {\"n\": " << point.n << ", \"bytes\": " << point.size
+          << ", \"parsed\": " << (point.parsed ? "true" : "false");
+      for (int metric = 0; metric < kNumMetrics; ++metric)
+        stm << ", \"" << kMetricNames[metric] << "\": " << point.values[metric];
+      stm << "}";
+      pointSep = ",\n";
+    }
+    stm << "\n      ]\n    }";
+    shapeSep = ",\n";
+  }
+  stm << "\n  }\n}\n";
+}
+
+int main(int argc, char** argv)
+{
+  std::string shapeNames;
+  for (const auto* name : kScalingShapeNames)
+    shapeNames += std::string(shapeNames.empty() ? "" : ", ") + name;
+
+  bpo::options_description desc("Benchmark of growth of time and memory with size of synthetic inputs");
+  desc.add_options()("help,h", "produce help message")(
+    "shape,s", bpo::value<std::vector<std::string>>(), ("Shape of input, can be repeated, all by default: " + shapeNames).c_str())(
+    "generate,g", "Only print generated input of each shape for size given by --max-n.")(
+    "min-n", bpo::value<size_t>()->default_value(16), "Smallest size of input.")(
+    "max-n", bpo::value<size_t>()->default_value(4096), "Largest size of input, size is doubled from smallest one.")(
+    "repeat,r", bpo::value<unsigned>()->default_value(3), "Number of times each input is processed, best time is kept.")(
+    "time-limit", bpo::value<double>()->default_value(10), "Seconds of parsing after which size of a shape is not grown.")(
+    "min-time", bpo::value<double>()->default_value(1e-4), "Times below this many seconds are left out of fitting.")(
+    "max-exponent",
+    bpo::value<double>()->default_value(1.5),
+    "Growth exponent above which growth is reported as superlinear and tool exits with 1.")(
+    "output,o", bpo::value<std::string>(), "File to write JSON result to.");
+
+  bpo::variables_map vm;
+  bpo::store(bpo::parse_command_line(argc, argv, desc), vm);
+  bpo::notify(vm);
+  if (vm.count("help"))
+  {
+    std::cout << desc << "\n";
+    return 0;
+  }
+
+  std::vector<ScalingShape> shapes;
+  if (vm.count("shape"))
+  {
+    for (const auto& name : vm["shape"].as<std::vector<std::string>>())
+    {
+      const auto shape = scalingShapeFromName(name.c_str());
+      if (shape == kNumScalingShapes)
+      {
+        std::cerr << "Error: Unknown shape '" << name << "'.\n\n" << desc << "\n";
+        return -1;
+      }
+      shapes.push_back(shape);
+    }
+  }
+  else
+  {
+    for (int shape = 0; shape < kNumScalingShapes; ++shape)
+      shapes.push_back(static_cast<ScalingShape>(shape));
+  }
+
+  const auto minN = std::max<size_t>(vm["min-n"].as<size_t>(), 1);
+  const auto maxN = vm["max-n"].as<size_t>();
+  if (vm.count("generate"))
+  {
+    for (auto shape : shapes)
+      std::cout << "// " << kScalingShapeNames[shape] << " N=" << maxN << '\n' << generateScalingInput(shape, maxN);
+    return 0;
+  }
+
+  const auto numRepeats     = std::max(vm["repeat"].as<unsigned>(), 1u);
+  const auto timeLimit      = vm["time-limit"].as<double>();
+  const auto minTime        = vm["min-time"].as<double>();
+  const auto maxExponent    = vm["max-exponent"].as<double>();
+  CppParser  parser         = constructCppParserForTest();
+  int        numSuperLinear = 0;
+
+  std::vector<ShapeResult> results;
+  for (auto shape : shapes)
+  {
+    ShapeResult result;
+    result.shape = shape;
+    for (size_t n = minN; n <= maxN; n *= 2)
+    {
+      result.points.push_back(measure(parser, shape, n, numRepeats));
+      const auto& point = result.points.back();
+      if (!point.parsed || (point.values[kParseTime] > timeLimit))
+        break;
+    }
+    for (int metric = 0; metric < kNumMetrics; ++metric)
+    {
+      result.fits[metric] = fitGrowth(result.points, metric, isTimeMetric(metric) ? minTime : 0);
+      if (result.fits[metric].valid && (result.fits[metric].exponent > maxExponent))
+      {
+        std::cerr << "SUPERLINEAR\t" << kScalingShapeNames[shape] << '/' << kMetricNames[metric]
+                  << ": exponent " << result.fits[metric].exponent << '\n';
+        ++numSuperLinear;
+      }
+    }
+    printResult(result);
+    results.push_back(std::move(result));
+  }
+
+  if (vm.count("output"))
+  {
+    std::ofstream out(vm["output"].as<std::string>());
+    writeJson(out, results);
+  }
+
+  return numSuperLinear ? 1 : 0;
+}
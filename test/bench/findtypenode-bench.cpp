@@ -0,0 +1,149 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2014
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Micro-benchmark of CppProgram::findTypeNode() over a synthetic program with deeply nested namespaces.
+
+#include "cppprog.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////
+
+static std::atomic<std::size_t> gNumAllocations{0};
+
+void* operator new(std::size_t size)
+{
+  ++gNumAllocations;
+  if (auto* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static const int kDepth           = 16;
+static const int kClassesPerScope = 64;
+static const int kNumLookupPasses = 2000;
+
+static std::string nsName(int level)
+{
+  return "ns" + std::to_string(level);
+}
+
+static std::string className(int level, int i)
+{
+  return "Class" + std::to_string(level) + "_" + std::to_string(i);
+}
+
+// Creates ns0::ns1::...::nsN each of which contains a set of classes.
+static CppCompoundPtr makeDeepNamespaceAst()
+{
+  CppCompoundPtr fileAst(new CppCompound("deep-namespace.h", CppCompoundType::kCppFile));
+  CppCompound*   scope = fileAst.get();
+  for (int level = 0; level < kDepth; ++level)
+  {
+    auto* ns = new CppCompound(nsName(level), CppCompoundType::kNamespace);
+    for (int i = 0; i < kClassesPerScope; ++i)
+      ns->addMember(new CppCompound(className(level, i), CppAccessType::kPublic, CppCompoundType::kClass));
+    scope->addMember(ns);
+    scope = ns;
+  }
+  return fileAst;
+}
+
+int main()
+{
+  CppProgram program(std::vector<std::string>{});
+  program.addCppAst(makeDeepNamespaceAst());
+
+  const CppTypeTreeNode* innermost = program.findTypeNode("", nullptr);
+  for (int level = 0; innermost && (level < kDepth); ++level)
+    innermost = program.findTypeNode(nsName(level), innermost);
+  if (innermost == nullptr)
+  {
+    std::cerr << "Failed to build synthetic program\n";
+    return 1;
+  }
+
+  // Names are prepared before timing so that only lookup is measured.
+  std::vector<std::string> unqualifiedNames;
+  std::vector<std::string> qualifiedNames;
+  for (int level = 0; level < kDepth; ++level)
+  {
+    std::string qualifiedScope;
+    for (int l = 0; l <= level; ++l)
+      qualifiedScope += nsName(l) + "::";
+    for (int i = 0; i < kClassesPerScope; i += 8)
+    {
+      unqualifiedNames.push_back(className(level, i));
+      qualifiedNames.push_back(qualifiedScope + className(level, i));
+    }
+  }
+  unqualifiedNames.push_back("NoSuchClass");
+  qualifiedNames.push_back("ns0::ns1::NoSuchClass");
+
+  auto runBenchmark = [&](const char* title, const std::vector<std::string>& names) {
+    // First pass fills the cache of lookups and so it is neither timed nor counted with the rest.
+    const auto allocsBeforeFirstPass = gNumAllocations.load();
+    for (const auto& name : names)
+      program.findTypeNode(name, innermost);
+    const auto numFirstPassAllocs = gNumAllocations.load() - allocsBeforeFirstPass;
+
+    std::size_t numFound     = 0;
+    const auto  allocsBefore = gNumAllocations.load();
+    const auto  startTime    = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < kNumLookupPasses; ++pass)
+    {
+      for (const auto& name : names)
+        numFound += (program.findTypeNode(name, innermost) != nullptr);
+    }
+    const auto endTime    = std::chrono::steady_clock::now();
+    const auto numLookups = names.size() * kNumLookupPasses;
+    const auto elapsedNs  = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    const auto numAllocs  = gNumAllocations.load() - allocsBefore;
+    std::cout << title << ":\t" << numLookups << " warm lookups, " << numFound << " found, "
+              << static_cast<double>(elapsedNs) / numLookups << " ns/lookup, " << numAllocs << " allocations ("
+              << numFirstPassAllocs << " in first pass)\n";
+  };
+
+  runBenchmark("Unqualified names", unqualifiedNames);
+  runBenchmark("Qualified names", qualifiedNames);
+
+  return 0;
+}
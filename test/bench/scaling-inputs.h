@@ -0,0 +1,122 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2014
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+// Generators of synthetic C++ sources whose size along one dimension is controlled by a single parameter N.
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+enum ScalingShape
+{
+  kNamespaceNesting,   ///< N namespaces nested in one another.
+  kClassMembers,       ///< A class with N data members.
+  kEnumItems,          ///< An enum with N items.
+  kExprOperands,       ///< An expression with N operands.
+  kFunctionParams,     ///< A function with N parameters.
+  kTemplateArgNesting, ///< Template argument nested N deep.
+  kInitializerList,    ///< An initializer list with N elements.
+  kNumScalingShapes
+};
+
+static const char* const kScalingShapeNames[kNumScalingShapes] = {
+  "namespace-nesting", "class-members", "enum-items", "expr-operands", "function-params", "template-nesting",
+  "initializer-list"};
+
+/// @return kNumScalingShapes if \a name is not name of any shape.
+inline ScalingShape scalingShapeFromName(const char* name)
+{
+  for (int shape = 0; shape < kNumScalingShapes; ++shape)
+  {
+    if (std::strcmp(name, kScalingShapeNames[shape]) == 0)
+      return static_cast<ScalingShape>(shape);
+  }
+  return kNumScalingShapes;
+}
+
+inline std::string generateScalingInput(ScalingShape shape, size_t n)
+{
+  std::string src;
+  switch (shape)
+  {
+    case kNamespaceNesting:
+      for (size_t i = 0; i < n; ++i)
+        src += "namespace n" + std::to_string(i) + " {\n";
+      src += "int x;\n";
+      for (size_t i = 0; i < n; ++i)
+        src += "}\n";
+      break;
+
+    case kClassMembers:
+      src += "class C\n{\npublic:\n";
+      for (size_t i = 0; i < n; ++i)
+        src += "  int m" + std::to_string(i) + ";\n";
+      src += "};\n";
+      break;
+
+    case kEnumItems:
+      src += "enum E\n{\n";
+      for (size_t i = 0; i < n; ++i)
+        src += "  e" + std::to_string(i) + " = " + std::to_string(i) + ",\n";
+      src += "};\n";
+      break;
+
+    case kExprOperands:
+      src += "int x = a0";
+      for (size_t i = 1; i < n; ++i)
+        src += (i % 2 ? " + a" : " * a") + std::to_string(i);
+      src += ";\n";
+      break;
+
+    case kFunctionParams:
+      src += "void f(";
+      for (size_t i = 0; i < n; ++i)
+        src += (i ? ", int p" : "int p") + std::to_string(i);
+      src += ");\n";
+      break;
+
+    case kTemplateArgNesting:
+      src += "using T = ";
+      for (size_t i = 0; i < n; ++i)
+        src += "A<";
+      src += "int";
+      for (size_t i = 0; i < n; ++i)
+        src += " >";
+      src += ";\n";
+      break;
+
+    case kInitializerList:
+      src += "int arr[] = {";
+      for (size_t i = 0; i < n; ++i)
+        src += (i ? ", " : "") + std::to_string(i);
+      src += "};\n";
+      break;
+
+    default:
+      break;
+  }
+
+  return src;
+}
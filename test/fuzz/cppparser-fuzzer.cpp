@@ -0,0 +1,132 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2014
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// libFuzzer harness of CppParser::parseStream() that reports inputs slow to parse, not only crashes.
+//
+// An input is a finding, and the process aborts so that libFuzzer saves it as a crash artifact, when:
+//  - parsing takes more than CPPPARSER_FUZZ_MAX_MS milliseconds (default 250), or
+//  - memory allocated while parsing is more than CPPPARSER_FUZZ_MAX_BYTES_PER_BYTE times the size of input (default 2000).
+//    Allocations are counted through sanitizer malloc hooks when built with a sanitizer, e.g. -fsanitize=address,
+//    otherwise size of the AST as computed by CppMemoryReport is used instead.
+//
+// Fuzzing seeded from e2e test input (parser errors go to stdout, hence -close_fd_mask=1):
+//    cppparserfuzzer -close_fd_mask=1 fuzz_corpus test/e2e/test_input
+// Minimising a finding and adding it to the regression corpus that cppparserbench replays:
+//    cppparserfuzzer -close_fd_mask=1 -minimize_crash=1 -runs=10000 -exact_artifact_path=test/fuzz/slow_inputs/<name>.h
+//        crash-<sha1>
+
+#include "cppmemoryreport.h"
+#include "cppparser.h"
+
+#include "../app/test-parser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+extern "C" int __sanitizer_install_malloc_and_free_hooks(void (*mallocHook)(const volatile void*, size_t),
+                                                         void (*freeHook)(const volatile void*))
+  __attribute__((weak));
+
+static std::atomic<size_t> gAllocatedBytes{0};
+static bool                gCountAllocations = false;
+
+static void onMalloc(const volatile void*, size_t size)
+{
+  gAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+static void onFree(const volatile void*)
+{
+}
+
+static double thresholdFromEnv(const char* name, double defaultValue)
+{
+  const char* value = std::getenv(name);
+  return value ? std::atof(value) : defaultValue;
+}
+
+static double gMaxMs           = 250;
+static double gMaxBytesPerByte = 2000;
+
+// Small inputs have fixed cost of parser that is not growth of memory.
+static const size_t kMinSizeForMemoryCheck = 256;
+
+static std::unique_ptr<CppParser> gParser;
+
+extern "C" int LLVMFuzzerInitialize(int*, char***)
+{
+  gMaxMs           = thresholdFromEnv("CPPPARSER_FUZZ_MAX_MS", gMaxMs);
+  gMaxBytesPerByte = thresholdFromEnv("CPPPARSER_FUZZ_MAX_BYTES_PER_BYTE", gMaxBytesPerByte);
+  if (__sanitizer_install_malloc_and_free_hooks)
+    gCountAllocations = __sanitizer_install_malloc_and_free_hooks(onMalloc, onFree) != 0;
+
+  gParser.reset(new CppParser(constructCppParserForTest()));
+  return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+  // Same layout of buffer as what CppParser::parseFile() passes to parser.
+  std::vector<char> contents(data, data + size);
+  contents.push_back('\n');
+  contents.push_back('\0');
+  contents.push_back('\0');
+
+  const auto allocatedBytesOrig = gAllocatedBytes.load();
+  const auto startTime          = std::chrono::steady_clock::now();
+  auto       cppAst             = gParser->parseStream(contents.data(), contents.size());
+  const auto ms =
+    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+  size_t memory = 0;
+  if (gCountAllocations)
+    memory = gAllocatedBytes.load() - allocatedBytesOrig;
+  else if (cppAst)
+    memory = CppMemoryReport(cppAst.get()).total().numBytes;
+
+  if (ms > gMaxMs)
+  {
+    std::fprintf(stderr, "SLOW INPUT: %zu bytes took %.1f ms to parse, limit is %.1f ms\n", size, ms, gMaxMs);
+    std::abort();
+  }
+  const auto bytesPerByte = static_cast<double>(memory) / std::max(size, kMinSizeForMemoryCheck);
+  if (bytesPerByte > gMaxBytesPerByte)
+  {
+    std::fprintf(stderr,
+                 "SLOW INPUT: %zu bytes needed %zu bytes of %s to parse, %.1f per byte, limit is %.1f\n",
+                 size,
+                 memory,
+                 gCountAllocations ? "allocations" : "AST",
+                 bytesPerByte,
+                 gMaxBytesPerByte);
+    std::abort();
+  }
+
+  return 0;
+}
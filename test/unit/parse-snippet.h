@@ -0,0 +1,20 @@
+#pragma once
+
+#include "cppast.h"
+#include "cppparser.h"
+
+#include <string>
+#include <vector>
+
+// Parses code of a test as if it were content of file at path.
+inline CppCompoundPtr parseSnippet(const std::string& path, const std::string& code)
+{
+  std::vector<char> stm(code.begin(), code.end());
+  stm.push_back('\0');
+  stm.push_back('\0');
+  CppParser parser;
+  auto      fileAst = parser.parseStream(stm.data(), stm.size(), path);
+  if (fileAst)
+    fileAst->name(path);
+  return fileAst;
+}
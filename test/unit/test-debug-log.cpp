@@ -0,0 +1,40 @@
+#include <catch/catch.hpp>
+
+#include "cppparser.h"
+
+#include "../../src/cppdebuglog.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+TEST_CASE("Debug logs of parser and btyacc go to log sink")
+{
+  std::vector<std::string> messages;
+  CppParser                parser;
+  parser.logSink([&messages](const char* msg) { messages.emplace_back(msg); });
+  parser.debugLog(CppParser::kParseLog | CppParser::kBtyaccLog);
+
+  const std::string input = "int x;\n";
+  std::vector<char> stm(input.begin(), input.end());
+  stm.push_back('\0');
+  stm.push_back('\0');
+  const auto ast = parser.parseStream(stm.data(), stm.size());
+
+  parser.debugLog(CppParser::kNoDebugLog);
+  parser.logSink(nullptr);
+  REQUIRE(ast != nullptr);
+
+  const auto hasMessage = [&messages](const std::string& prefix) {
+    return std::any_of(messages.begin(), messages.end(), [&prefix](const std::string& msg) {
+      return msg.compare(0, prefix.size(), prefix) == 0;
+    });
+  };
+#if CPPPARSER_DEBUG_LOG
+  CHECK(hasMessage("ZZLOG @line#"));
+  CHECK(hasMessage("yydebug["));
+#else
+  CHECK(messages.empty());
+  CHECK(!hasMessage("yydebug["));
+#endif
+}
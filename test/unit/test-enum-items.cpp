@@ -0,0 +1,144 @@
+#include <catch/catch.hpp>
+
+#include "cppast.h"
+#include "cppobjfactory.h"
+#include "cppparser.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Same as what parser makes of an enum when CppParser::parseEnumBodyAsBlob() is used.
+std::unique_ptr<CppEnum> makeBlobEnum(std::string body)
+{
+  auto* itemList = new CppEnumItemList;
+  itemList->emplace_back(new CppEnumItem(new CppBlob(std::move(body))));
+  return std::unique_ptr<CppEnum>(new CppEnum(CppAccessType::kUnknown, "Color", itemList, true));
+}
+
+// Enum bodies are kept as blob by all parsers, so this makes them parsed again even when a REQUIRE fails.
+struct EnumBodyAsBlobReset
+{
+  CppParser& parser;
+  ~EnumBodyAsBlobReset()
+  {
+    parser.parseEnumBodyAsBlob(false);
+  }
+};
+
+class CountingObjFactory : public CppObjFactory
+{
+public:
+  CppCompound* CreateCompound(std::string name, CppAccessType accessType, CppCompoundType type) const override
+  {
+    ++numCreated;
+    return CppObjFactory::CreateCompound(std::move(name), accessType, type);
+  }
+  CppCompound* CreateCompound(CppAccessType accessType, CppCompoundType type) const override
+  {
+    ++numCreated;
+    return CppObjFactory::CreateCompound(accessType, type);
+  }
+  CppCompound* CreateCompound(std::string name, CppCompoundType type) const override
+  {
+    ++numCreated;
+    return CppObjFactory::CreateCompound(std::move(name), type);
+  }
+  CppCompound* CreateCompound(CppCompoundType type) const override
+  {
+    ++numCreated;
+    return CppObjFactory::CreateCompound(type);
+  }
+
+  mutable int numCreated = 0;
+};
+
+} // namespace
+
+TEST_CASE("Items of enum whose body is a blob")
+{
+  auto enm = makeBlobEnum("\n  kRed,\n  kGreen = 2,\n  kBlue = kGreen + 1\n");
+  REQUIRE(enm->isBodyBlob());
+
+  const auto* items = enm->items();
+  REQUIRE(items != nullptr);
+  REQUIRE(items->size() == 3);
+  CHECK((*items)[0]->name_ == "kRed");
+  CHECK((*items)[1]->name_ == "kGreen");
+  CHECK((*items)[1]->val_ != nullptr);
+  CHECK((*items)[2]->name_ == "kBlue");
+
+  // Blob is parsed only once.
+  CHECK(enm->items() == items);
+  // Blob itself is kept as it is.
+  CHECK(enm->itemList_->size() == 1);
+}
+
+TEST_CASE("Items of enum whose body is a blob are made by given factory")
+{
+  CountingObjFactory objFactory;
+  auto               enm = makeBlobEnum("kRed, kGreen");
+
+  const auto* items = enm->items(&objFactory);
+  REQUIRE(items != nullptr);
+  CHECK(items->size() == 2);
+  CHECK(objFactory.numCreated > 0);
+
+  // Blob is already parsed and so later factory is not used.
+  CountingObjFactory otherObjFactory;
+  CHECK(enm->items(&otherObjFactory) == items);
+  CHECK(otherObjFactory.numCreated == 0);
+}
+
+TEST_CASE("Items of enum whose body is parsed")
+{
+  auto* itemList = new CppEnumItemList;
+  itemList->emplace_back(new CppEnumItem("kOne"));
+  CppEnum enm(CppAccessType::kUnknown, "Number", itemList);
+
+  CHECK(!enm.isBodyBlob());
+  CHECK(enm.items() == enm.itemList_.get());
+}
+
+TEST_CASE("Items of forward declared enum")
+{
+  CppEnum enm(CppAccessType::kUnknown, "Number", nullptr);
+
+  CHECK(!enm.isBodyBlob());
+  CHECK(enm.items() == nullptr);
+}
+
+TEST_CASE("Items of enum whose body is kept as blob by lexer")
+{
+  CppParser           parser;
+  EnumBodyAsBlobReset reset{parser};
+  parser.parseEnumBodyAsBlob();
+
+  std::string       input = "enum class Color : int {\n  kRed,\n  kGreen = 2,\n  kBlue = kGreen + 1\n};\n";
+  std::vector<char> stm(input.begin(), input.end());
+  stm.push_back('\0');
+  stm.push_back('\0');
+  auto cppAst = parser.parseStream(stm.data(), stm.size());
+  REQUIRE(cppAst != nullptr);
+  REQUIRE(cppAst->members().size() == 1);
+  REQUIRE(cppAst->members().front()->objType_ == CppEnum::kObjectType);
+
+  const auto* enm = static_cast<const CppEnum*>(cppAst->members().front().get());
+  REQUIRE(enm->isBodyBlob());
+  const auto* items = enm->items();
+  REQUIRE(items != nullptr);
+  REQUIRE(items->size() == 3);
+  CHECK((*items)[0]->name_ == "kRed");
+  CHECK((*items)[2]->name_ == "kBlue");
+
+  parser.parseEnumBodyAsBlob(false);
+  stm.assign(input.begin(), input.end());
+  stm.push_back('\0');
+  stm.push_back('\0');
+  cppAst = parser.parseStream(stm.data(), stm.size());
+  REQUIRE(cppAst != nullptr);
+  REQUIRE(cppAst->members().size() == 1);
+  CHECK(!static_cast<const CppEnum*>(cppAst->members().front().get())->isBodyBlob());
+}
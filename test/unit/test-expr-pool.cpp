@@ -0,0 +1,50 @@
+#include <catch/catch.hpp>
+
+#include "cppexprpool.h"
+#include "cppparser.h"
+#include "cppwriter.h"
+
+#include <boost/filesystem.hpp>
+
+#include <sstream>
+
+namespace fs = boost::filesystem;
+
+TEST_CASE("Expression pool of function body")
+{
+  CppParser parser;
+  auto      testFilePath = fs::path(__FILE__).parent_path() / "test-files/hello-world.cpp";
+  auto      ast          = parser.parseFile(testFilePath.string());
+  REQUIRE(ast != nullptr);
+
+  CppFunctionEPtr func = ast->members()[1];
+  REQUIRE(func);
+  REQUIRE(func->defn());
+
+  CppExprPool pool(func->defn());
+  REQUIRE(pool.roots().size() == 2);
+
+  const auto& coutHelloWorld = pool.node(pool.roots()[0]);
+  CHECK(coutHelloWorld.oper == CppOperator::kInsertion);
+  CHECK(coutHelloWorld.atoms[0].type == CppExprAtom::kAtom);
+  CHECK(pool.atom(coutHelloWorld.atoms[0].idx) == "std::cout");
+
+  // Children must precede parent.
+  for (const auto& node : pool.nodes())
+  {
+    for (const auto& atom : node.atoms)
+    {
+      if (atom.type == CppExprAtom::kExpr)
+        CHECK(&pool.node(atom.idx) < &node);
+    }
+  }
+
+  CppWriter writer;
+  for (auto root : pool.roots())
+  {
+    std::ostringstream fromPool, fromExpr;
+    writer.emitExpr(pool, root, fromPool);
+    writer.emitExpr(pool.expr(root), fromExpr);
+    CHECK(fromPool.str() == fromExpr.str());
+  }
+}
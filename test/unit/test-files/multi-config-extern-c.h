@@ -0,0 +1,9 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int api;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,21 @@
+int common1;
+
+#ifdef _WIN32
+int win;
+#elif defined(__APPLE__)
+int mac;
+#else
+int other;
+#endif
+
+int common2;
+
+class Window
+{
+public:
+#ifdef _WIN32
+  int hwnd;
+#else
+  int handle;
+#endif
+};
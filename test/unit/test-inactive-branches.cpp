@@ -0,0 +1,154 @@
+#include <catch/catch.hpp>
+
+#include "cppast.h"
+#include "cppparser.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Macros and skipping are global to all parsers, so the test resets them at its end for other tests to be unaffected.
+const char* const kInput = "#if TEST_SKIP_FEATURE\n"
+                           "int active1;\n"
+                           "#else\n"
+                           "int inactive1;\n"
+                           "#endif\n"
+                           "#ifdef TEST_SKIP_MISSING\n"
+                           "int inactive2;\n"
+                           "#  if 1\n"
+                           "int inactive3;\n"
+                           "#  else\n"
+                           "int inactive4;\n"
+                           "#  endif\n"
+                           "#elif TEST_SKIP_VERSION >= 3 && !defined(TEST_SKIP_MISSING)\n"
+                           "int active2;\n"
+                           "#else\n"
+                           "int inactive5;\n"
+                           "#endif\n"
+                           "#if TEST_SKIP_UNKNOWN\n"
+                           "int parsed1;\n"
+                           "#else\n"
+                           "int parsed2;\n"
+                           "#endif\n";
+
+CppCompoundPtr parse(CppParser& parser, const char* text = kInput)
+{
+  std::string       input(text);
+  std::vector<char> stm(input.begin(), input.end());
+  stm.push_back('\0');
+  stm.push_back('\0');
+  return parser.parseStream(stm.data(), stm.size());
+}
+
+std::set<std::string> varNames(const CppCompound* compound)
+{
+  std::set<std::string> names;
+  for (const auto& mem : compound->members())
+  {
+    if (mem->objType_ == CppObjType::kVar)
+      names.insert(static_cast<const CppVar*>(mem.get())->name());
+  }
+  return names;
+}
+
+size_t countMembers(const CppCompound* compound, CppObjType objType)
+{
+  size_t count = 0;
+  for (const auto& mem : compound->members())
+  {
+    if (mem->objType_ == objType)
+      ++count;
+  }
+  return count;
+}
+
+// Resets skipping and macros even when a REQUIRE fails.
+struct SkippingReset
+{
+  CppParser& parser;
+  ~SkippingReset()
+  {
+    parser.skipInactivePreproBranches(false);
+    parser.clearMacros();
+  }
+};
+
+} // namespace
+
+TEST_CASE("Skipping of inactive branches of #if")
+{
+  CppParser     parser;
+  SkippingReset reset{parser};
+  parser.defineMacro("TEST_SKIP_FEATURE");
+  parser.defineMacro("TEST_SKIP_VERSION", "TEST_SKIP_FEATURE + 2");
+  parser.undefineMacro("TEST_SKIP_MISSING");
+
+  SECTION("Without placeholders")
+  {
+    parser.skipInactivePreproBranches();
+    auto cppAst = parse(parser);
+    REQUIRE(cppAst != nullptr);
+    CHECK(varNames(cppAst.get()) == std::set<std::string>{"active1", "active2", "parsed1", "parsed2"});
+    CHECK(countMembers(cppAst.get(), CppObjType::kHashIf) == 10);
+    CHECK(countMembers(cppAst.get(), CppObjType::kBlob) == 0);
+  }
+
+  SECTION("With placeholders")
+  {
+    parser.skipInactivePreproBranches(true, true);
+    auto cppAst = parse(parser);
+    REQUIRE(cppAst != nullptr);
+    CHECK(varNames(cppAst.get()) == std::set<std::string>{"active1", "active2", "parsed1", "parsed2"});
+    REQUIRE(countMembers(cppAst.get(), CppObjType::kBlob) == 3);
+
+    std::vector<std::string> blobs;
+    for (const auto& mem : cppAst->members())
+    {
+      if (mem->objType_ == CppObjType::kBlob)
+        blobs.push_back(static_cast<const CppBlob*>(mem.get())->blob_);
+    }
+    CHECK(blobs[0] == "int inactive1;\n");
+    CHECK(blobs[1] == "int inactive2;\n#  if 1\nint inactive3;\n#  else\nint inactive4;\n#  endif\n");
+    CHECK(blobs[2] == "int inactive5;\n");
+  }
+
+  SECTION("Switched off")
+  {
+    parser.skipInactivePreproBranches();
+    parser.skipInactivePreproBranches(false);
+    auto cppAst = parse(parser);
+    REQUIRE(cppAst != nullptr);
+    CHECK(varNames(cppAst.get())
+          == std::set<std::string>{
+            "active1", "inactive1", "inactive2", "inactive3", "inactive4", "active2", "inactive5", "parsed1", "parsed2"});
+    CHECK(countMembers(cppAst.get(), CppObjType::kBlob) == 0);
+  }
+}
+
+TEST_CASE("Directives in comments and continuation lines of inactive branches")
+{
+  CppParser     parser;
+  SkippingReset reset{parser};
+  parser.skipInactivePreproBranches();
+
+  const char* const input = "#if 0\n"
+                            "/* Disabled:\n"
+                            "#if 1\n"
+                            "*/\n"
+                            "#define SPLIT \\\n"
+                            "#if 1\n"
+                            "int inactive1;\n"
+                            "#else\n"
+                            "int active1;\n"
+                            "#endif\n"
+                            "#if 0 /* Disabled as well,\n"
+                            "#endif */\n"
+                            "int inactive2;\n"
+                            "#endif\n"
+                            "int active2;\n";
+  auto cppAst = parse(parser, input);
+  REQUIRE(cppAst != nullptr);
+  CHECK(varNames(cppAst.get()) == std::set<std::string>{"active1", "active2"});
+}
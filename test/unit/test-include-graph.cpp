@@ -0,0 +1,85 @@
+#include <catch/catch.hpp>
+
+#include "cppprog.h"
+#include "parse-snippet.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+CppCompoundPtr makeFileAst(const std::string& path, const std::vector<std::string>& includes)
+{
+  std::string code;
+  for (const auto& include : includes)
+    code += "#include " + include + "\n";
+  // Parser gives no AST for input without any statement.
+  code += "struct Declared;\n";
+  return parseSnippet(path, code);
+}
+
+size_t position(const CppFileAstArray& files, const CppCompound* file)
+{
+  return std::find(files.begin(), files.end(), file) - files.begin();
+}
+
+} // namespace
+
+TEST_CASE("Include graph of program")
+{
+  CppProgram program(std::vector<std::string>{});
+  program.includeRoots({"/proj/include"});
+
+  CppCompoundArray fileAsts;
+  fileAsts.push_back(makeFileAst("/proj/src/app.h", {"\"widget.h\"", "<base/object.h>", "<vector>"}));
+  fileAsts.push_back(makeFileAst("/proj/src/widget.h", {"<base/object.h>", "\"../src/app.h\""}));
+  fileAsts.push_back(makeFileAst("/proj/include/base/object.h", {}));
+  // Include through a macro cannot be resolved without expanding it.
+  fileAsts.push_back(makeFileAst("/proj/src/unrelated.h", {"BASE_OBJECT_H"}));
+  program.addCppAsts(std::move(fileAsts), 1);
+
+  const auto& files  = program.getFileAsts();
+  const auto* app    = files[0].get();
+  const auto* widget = files[1].get();
+  const auto* object = files[2].get();
+  const auto* other  = files[3].get();
+
+  const auto& graph = program.includeGraph();
+  CHECK(graph.includes(app) == CppFileAstArray({widget, object}));
+  CHECK(graph.includedBy(object) == CppFileAstArray({app, widget}));
+  REQUIRE(graph.unresolvedIncludes(app).size() == 1);
+  CHECK(graph.unresolvedIncludes(app).front()->name_ == "<vector>");
+  CHECK(graph.includes(other).empty());
+  REQUIRE(graph.unresolvedIncludes(other).size() == 1);
+  CHECK(graph.unresolvedIncludes(other).front()->name_ == "BASE_OBJECT_H");
+
+  const auto& order = graph.topologicalOrder();
+  REQUIRE(order.size() == 4);
+  CHECK(position(order, object) < position(order, widget));
+  CHECK(position(order, object) < position(order, app));
+
+  auto dependents = graph.dependents(object);
+  CHECK(dependents.size() == 2);
+  CHECK(std::is_sorted(dependents.begin(), dependents.end(), [&](const CppCompound* lhs, const CppCompound* rhs) {
+    return position(order, lhs) < position(order, rhs);
+  }));
+  CHECK(graph.dependents(other).empty());
+
+  SECTION("Graph follows removal and addition of files")
+  {
+    REQUIRE(program.removeFile("/proj/src/widget.h"));
+    CHECK(&program.includeGraph() == &graph);
+    CHECK(graph.includes(app) == CppFileAstArray({object}));
+    CHECK(graph.includedBy(object) == CppFileAstArray({app}));
+    CHECK(graph.unresolvedIncludes(app).size() == 2);
+    CHECK(graph.topologicalOrder().size() == 3);
+
+    program.addCppAst(makeFileAst("/proj/src/widget.h", {"<base/object.h>"}));
+    const auto* newWidget = program.getFileAsts().back().get();
+    CHECK(graph.includes(app) == CppFileAstArray({object, newWidget}));
+    CHECK(graph.includedBy(object) == CppFileAstArray({app, newWidget}));
+    REQUIRE(graph.unresolvedIncludes(app).size() == 1);
+    CHECK(graph.unresolvedIncludes(app).front()->name_ == "<vector>");
+    CHECK(graph.dependents(newWidget) == CppFileAstArray({app}));
+  }
+}
@@ -0,0 +1,70 @@
+#include <catch/catch.hpp>
+
+#include "cppmemoryreport.h"
+#include "parse-snippet.h"
+
+namespace {
+
+CppCompoundPtr makeFileAst()
+{
+  return parseSnippet("file.h",
+                      "#ifndef FILE_H\n"
+                      "int global = 1;\n"
+                      "namespace Outer {\n"
+                      "class Widget {\n"
+                      "  int member = 2;\n"
+                      "  template <typename T> void func();\n"
+                      "};\n"
+                      "}\n"
+                      "namespace Outer { int other = 3; }\n"
+                      "#endif\n");
+}
+
+} // namespace
+
+TEST_CASE("Memory report by object type")
+{
+  const auto            fileAst = makeFileAst();
+  const CppMemoryReport report(fileAst.get());
+
+  CHECK(report.ofType(CppObjType::kCompound).numObjs == 4);
+  CHECK(report.ofType(CppObjType::kVar).numObjs == 3);
+  CHECK(report.ofType(CppObjType::kVarType).numObjs == 4);
+  CHECK(report.ofType(CppObjType::kExpression).numObjs == 3);
+  CHECK(report.ofType(CppObjType::kFunction).numObjs == 1);
+  CHECK(report.ofType(CppObjType::kHashIf).numObjs == 2);
+  CHECK(report.ofType(CppObjType::kVar).numBytes >= 3 * sizeof(CppVar));
+
+  const auto total = report.total();
+  CHECK(total.numObjs == 17);
+
+  REQUIRE(report.byFile().size() == 1);
+  CHECK(report.byFile().at("file.h").numObjs == total.numObjs);
+  CHECK(report.byFile().at("file.h").numBytes == total.numBytes);
+
+  REQUIRE(report.byNamespace().size() == 2);
+  const auto& global = report.byNamespace().at("");
+  const auto& outer  = report.byNamespace().at("Outer");
+  CHECK(global.numObjs == 6);
+  CHECK(outer.numObjs == 11);
+  CHECK(global.numBytes + outer.numBytes == total.numBytes);
+}
+
+TEST_CASE("Memory report counts owned heap data")
+{
+  const auto shortAtoms = parseSnippet("file.h", "int v = 1;\n");
+  const auto longAtoms  = parseSnippet("file.h", "int v = 0x0123456789ABCDEF0123456789ABCDEF;\n");
+
+  const CppMemoryReport shortReport(shortAtoms.get());
+  const CppMemoryReport longReport(longAtoms.get());
+  CHECK(longReport.ofType(CppObjType::kExpression).numBytes
+        == shortReport.ofType(CppObjType::kExpression).numBytes + 34);
+
+  const auto withTemplate    = parseSnippet("file.h", "template <typename T> class Widget {};\n");
+  const auto withoutTemplate = parseSnippet("file.h", "class Widget {};\n");
+
+  const CppMemoryReport templReport(withTemplate.get());
+  const CppMemoryReport plainReport(withoutTemplate.get());
+  CHECK(templReport.ofType(CppObjType::kCompound).numBytes
+        >= plainReport.ofType(CppObjType::kCompound).numBytes + sizeof(CppTemplateParamList) + sizeof(CppTemplateParam));
+}
@@ -0,0 +1,94 @@
+#include <catch/catch.hpp>
+
+#include "cppast.h"
+#include "cppparser.h"
+
+#include <boost/filesystem.hpp>
+
+#include <set>
+#include <string>
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+std::set<std::string> varNames(const CppConfigAst& configAst, const CppCompound* compound)
+{
+  std::set<std::string> names;
+  for (const auto* mem : configAst.members(compound))
+  {
+    if (mem->objType_ == CppObjType::kVar)
+      names.insert(static_cast<const CppVar*>(mem)->name());
+  }
+  return names;
+}
+
+std::set<std::string> varNames(const CppConfigAst& configAst)
+{
+  return varNames(configAst, configAst.get());
+}
+
+const CppCompound* findCompound(const CppConfigAst& configAst, const CppCompound* compound)
+{
+  for (const auto* mem : configAst.members(compound))
+  {
+    if (mem->objType_ == CppObjType::kCompound)
+      return static_cast<const CppCompound*>(mem);
+  }
+  return nullptr;
+}
+
+} // namespace
+
+TEST_CASE("Parsing of a file for multiple configurations")
+{
+  CppParser  parser;
+  const auto testFilePath = (fs::path(__FILE__).parent_path() / "test-files/multi-config.h").string();
+
+  const auto cppAsts = parser.parseFileForConfigs(testFilePath,
+                                                  {{{"_WIN32", "1"}},
+                                                   {{"__APPLE__", "1"}},
+                                                   {{"_WIN32", "1"}, {"UNUSED_IN_FILE", "1"}},
+                                                   {}});
+  REQUIRE(cppAsts.size() == 4);
+  for (const auto& cppAst : cppAsts)
+    REQUIRE(cppAst);
+
+  CHECK(varNames(cppAsts[0]) == std::set<std::string>{"common1", "win", "common2"});
+  CHECK(varNames(cppAsts[1]) == std::set<std::string>{"common1", "mac", "common2"});
+  CHECK(varNames(cppAsts[3]) == std::set<std::string>{"common1", "other", "common2"});
+
+  const auto* winClass = findCompound(cppAsts[0], cppAsts[0].get());
+  REQUIRE(winClass != nullptr);
+  CHECK(varNames(cppAsts[0], winClass) == std::set<std::string>{"hwnd"});
+  CHECK(varNames(cppAsts[1], winClass) == std::set<std::string>{"handle"});
+
+  // File is parsed once and configurations that choose same branches share the view of it too.
+  CHECK(cppAsts[1].ast() == cppAsts[0].ast());
+  CHECK(cppAsts[3].ast() == cppAsts[0].ast());
+  CHECK(cppAsts[2] == cppAsts[0]);
+  CHECK(cppAsts[1] != cppAsts[0]);
+  CHECK(cppAsts[3] != cppAsts[0]);
+  CHECK(cppAsts[0]->name() == testFilePath);
+}
+
+TEST_CASE("Parsing of a file for multiple configurations whose branches open a block")
+{
+  CppParser  parser;
+  const auto testFilePath = (fs::path(__FILE__).parent_path() / "test-files/multi-config-extern-c.h").string();
+
+  const auto cppAsts = parser.parseFileForConfigs(testFilePath, {{{"__cplusplus", "1"}}, {}});
+  REQUIRE(cppAsts.size() == 2);
+  REQUIRE(cppAsts[0]);
+  REQUIRE(cppAsts[1]);
+
+  // A view of one AST cannot move "int api;" out of the extern "C" block, so each configuration is parsed separately.
+  CHECK(cppAsts[1].ast() != cppAsts[0].ast());
+  CHECK(varNames(cppAsts[0]).empty());
+  CHECK(varNames(cppAsts[1]) == std::set<std::string>{"api"});
+
+  const auto* block = findCompound(cppAsts[0], cppAsts[0].get());
+  REQUIRE(block != nullptr);
+  CHECK(block->compoundType() == CppCompoundType::kExternCBlock);
+  CHECK(varNames(cppAsts[0], block) == std::set<std::string>{"api"});
+}
@@ -0,0 +1,127 @@
+#include <catch/catch.hpp>
+
+#include "cppoutputbuffer.h"
+#include "cppwriter.h"
+#include "parse-snippet.h"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+CppCompoundPtr makeFileAst()
+{
+  return parseSnippet("file.h",
+                      "namespace Outer {\n"
+                      "class Widget { struct Nested {}; };\n"
+                      "struct Gadget {};\n"
+                      "}\n");
+}
+
+CppCompoundPtr makeFileAst(int fileIdx)
+{
+  const auto idx = std::to_string(fileIdx);
+  return parseSnippet("file" + idx + ".h",
+                      "#ifndef FILE_" + idx + "\n#if DEPTH > " + std::to_string(fileIdx % 3) + "\nclass Class" + idx
+                        + " {};\n#endif\n#endif\n");
+}
+
+std::string readFile(const boost::filesystem::path& path)
+{
+  std::ifstream      in(path.string());
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+} // namespace
+
+TEST_CASE("Output buffer")
+{
+  CppOutputBuffer buffer(4);
+  buffer.append("abc", 3);
+  buffer.append('d');
+  buffer.append(boost::string_view("efgh"));
+  CHECK(buffer.str() == "abcdefgh");
+
+  CppIndent indentation(1, CppIndent::kQuadSpace);
+  ++indentation;
+  buffer.clear();
+  buffer.append(indentation);
+  CHECK(buffer.str() == "        ");
+  CHECK(indentation.toString() == buffer.str().to_string());
+
+  CppIndent deepIndentation(300, CppIndent::kTab);
+  CHECK(deepIndentation.toString() == std::string(300, '\t'));
+}
+
+TEST_CASE("Output inserter")
+{
+  const auto insert = [](std::ostream& stm) {
+    CppOutputInserter out(stm);
+    out << CppIndent(1) << "class" << ' ' << std::string("Widget") << boost::string_view(" : Base") << ' ' << 42;
+  };
+
+  std::ostringstream expected;
+  CHECK(CppOutputStream::bufferOf(expected) == nullptr);
+  insert(expected);
+  CHECK(expected.str() == "  class Widget : Base 42");
+
+  CppOutputStream stm(4);
+  CHECK(CppOutputStream::bufferOf(stm) == &stm.buffer());
+  insert(stm);
+  CHECK(stm.buffer().str() == expected.str());
+
+  std::ostringstream other;
+  auto*              ownBuf = stm.rdbuf(other.rdbuf());
+  CHECK(CppOutputStream::bufferOf(stm) == nullptr);
+  insert(stm);
+  CHECK(other.str() == expected.str());
+  stm.rdbuf(ownBuf);
+}
+
+TEST_CASE("Emitting into output stream")
+{
+  auto      fileAst = makeFileAst();
+  CppWriter cppWriter;
+
+  std::ostringstream expected;
+  cppWriter.emit(fileAst.get(), expected);
+
+  CppOutputStream stm(16);
+  cppWriter.emit(fileAst.get(), stm);
+  CHECK(stm.buffer().str() == expected.str());
+
+  std::ostringstream copy;
+  copy << stm.buffer();
+  CHECK(copy.str() == expected.str());
+}
+
+TEST_CASE("Concurrent emission of files")
+{
+  const int                   kNumFiles  = 24;
+  const auto                  outputPath = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  std::vector<CppCompoundPtr> fileAsts;
+  std::vector<CppEmitJob>     jobs;
+  for (int i = 0; i < kNumFiles; ++i)
+  {
+    fileAsts.push_back(makeFileAst(i));
+    const auto subFolder = outputPath / ("sub" + std::to_string(i % 2));
+    jobs.emplace_back(fileAsts.back().get(), (subFolder / fileAsts.back()->name()).string());
+  }
+
+  CppWriter cppWriter;
+  CHECK(cppWriter.emitFiles(jobs, 4).empty());
+
+  for (const auto& job : jobs)
+  {
+    std::ostringstream expected;
+    cppWriter.emit(job.first, expected);
+    CHECK(readFile(job.second) == expected.str());
+  }
+  CHECK(readFile(jobs[0].second) == "#ifndef FILE_0\n#  if DEPTH > 0\nclass Class0\n{\n};\n#  endif\n#endif\n");
+
+  boost::filesystem::remove_all(outputPath);
+}
@@ -0,0 +1,166 @@
+#include <catch/catch.hpp>
+
+#include "cppobjfactory.h"
+#include "cppparser.h"
+
+#include <boost/filesystem.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+// Pretends that every call is preceded by a thousand allocations.
+static std::size_t countAllocations()
+{
+  static std::size_t numAllocs = 0;
+  return numAllocs += 1000;
+}
+
+static std::vector<char> toStream(const std::string& input)
+{
+  std::vector<char> stm(input.begin(), input.end());
+  stm.push_back('\0');
+  stm.push_back('\0');
+  return stm;
+}
+
+static std::vector<char> longInput()
+{
+  std::string input;
+  for (int i = 0; i < 5000; ++i)
+    input += "int x" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+  return toStream(input);
+}
+
+static std::vector<char> nestedInput()
+{
+  std::string input;
+  for (int i = 0; i < 50; ++i)
+  {
+    const auto n = std::to_string(i);
+    input += "namespace N" + n + " {\nclass C" + n + " : public B {\npublic:\n  C" + n + "(int a) : x(a + 1) {}\n";
+    input += "  int f(int a, int b) const { return a * b; }\n  int x = 1 + 2;\n};\n}\n";
+  }
+  return toStream(input);
+}
+
+namespace {
+
+/// Compound that counts its instances that are alive.
+struct CountedCompound : public CppCompound
+{
+  template <typename... Params>
+  CountedCompound(Params&&... params)
+    : CppCompound(std::forward<Params>(params)...)
+  {
+    ++numAlive;
+  }
+  ~CountedCompound() override
+  {
+    --numAlive;
+  }
+
+  static int numAlive;
+};
+
+int CountedCompound::numAlive = 0;
+
+class CountingObjFactory : public CppObjFactory
+{
+public:
+  CppCompound* CreateCompound(std::string name, CppAccessType accessType, CppCompoundType type) const override
+  {
+    return new CountedCompound(std::move(name), accessType, type);
+  }
+  CppCompound* CreateCompound(CppAccessType accessType, CppCompoundType type) const override
+  {
+    return new CountedCompound(accessType, type);
+  }
+  CppCompound* CreateCompound(std::string name, CppCompoundType type) const override
+  {
+    return new CountedCompound(std::move(name), type);
+  }
+  CppCompound* CreateCompound(CppCompoundType type) const override
+  {
+    return new CountedCompound(type);
+  }
+};
+
+} // namespace
+
+TEST_CASE("Cancellation and budgets of parsing")
+{
+  CppParser  parser;
+  const auto testFilePath = (fs::path(__FILE__).parent_path() / "test-files/hello-world.cpp").string();
+
+  SECTION("No limits by default")
+  {
+    REQUIRE(parser.parseFile(testFilePath) != nullptr);
+    CHECK(parser.lastParseStatus() == CppParseStatus::kSuccess);
+    CHECK(parser.parseFile(testFilePath + ".missing") == nullptr);
+    CHECK(parser.lastParseStatus() == CppParseStatus::kParseError);
+  }
+
+  SECTION("Cancellation")
+  {
+    CppCancellationToken token;
+    parser.cancellationToken(&token);
+    REQUIRE(parser.parseFile(testFilePath) != nullptr);
+
+    token.cancel();
+    CHECK(parser.parseFile(testFilePath) == nullptr);
+    CHECK(parser.lastParseStatus() == CppParseStatus::kCancelled);
+
+    token.reset();
+    CHECK(parser.parseFile(testFilePath) != nullptr);
+    CHECK(parser.lastParseStatus() == CppParseStatus::kSuccess);
+  }
+
+  SECTION("Time budget")
+  {
+    parser.timeBudget(std::chrono::nanoseconds(1));
+    auto stm = longInput();
+    CHECK(parser.parseStream(stm.data(), stm.size()) == nullptr);
+    CHECK(parser.lastParseStatus() == CppParseStatus::kTimeBudgetExceeded);
+
+    parser.timeBudget(std::chrono::steady_clock::duration::zero());
+    stm = longInput();
+    CHECK(parser.parseStream(stm.data(), stm.size()) != nullptr);
+    CHECK(parser.lastParseStatus() == CppParseStatus::kSuccess);
+  }
+
+  SECTION("Allocation budget")
+  {
+    parser.allocationBudget(10);
+    auto stm = longInput();
+    CHECK(parser.parseStream(stm.data(), stm.size()) != nullptr); // No effect without allocation counter.
+
+    parser.setAllocationCounter(countAllocations);
+    stm = longInput();
+    CHECK(parser.parseStream(stm.data(), stm.size()) == nullptr);
+    CHECK(parser.lastParseStatus() == CppParseStatus::kAllocationBudgetExceeded);
+  }
+}
+
+TEST_CASE("Values of stopped parsing are deleted")
+{
+  CppParser parser(CppObjFactoryPtr(new CountingObjFactory));
+  auto      stm = nestedInput();
+  REQUIRE(parser.parseStream(stm.data(), stm.size()) != nullptr);
+  CHECK(CountedCompound::numAlive == 0);
+
+  // Every budget stops parsing at a different token.
+  static std::size_t numChecks = 0;
+  parser.setAllocationCounter([]() { return ++numChecks; });
+  for (std::size_t budget = 1; budget <= 20; ++budget)
+  {
+    numChecks = 0;
+    parser.allocationBudget(budget);
+    stm = nestedInput();
+    CHECK(parser.parseStream(stm.data(), stm.size()) == nullptr);
+    CHECK(parser.lastParseStatus() == CppParseStatus::kAllocationBudgetExceeded);
+    CHECK(CountedCompound::numAlive == 0);
+  }
+}
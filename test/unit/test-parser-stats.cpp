@@ -0,0 +1,43 @@
+#include <catch/catch.hpp>
+
+#include "cppparser.h"
+
+#include <boost/filesystem.hpp>
+
+namespace fs = boost::filesystem;
+
+TEST_CASE("Statistics of parsing")
+{
+  CppParser  parser;
+  const auto testFilePath = (fs::path(__FILE__).parent_path() / "test-files/hello-world.cpp").string();
+
+  SECTION("Not collected by default")
+  {
+    REQUIRE(parser.parseFile(testFilePath) != nullptr);
+    CHECK(parser.stats().numParses == 0);
+    CHECK(parser.stats().totalObjs() == 0);
+  }
+
+  SECTION("Collected when enabled")
+  {
+    parser.collectStats();
+    REQUIRE(parser.parseFile(testFilePath) != nullptr);
+    const auto& stats = parser.lastParseStats();
+    CHECK(stats.numParses == 1);
+    CHECK(stats.numBytes >= fs::file_size(testFilePath));
+    CHECK(stats.numTokens > 10);
+    CHECK(stats.numReductions > stats.numTokens / 2);
+    CHECK(stats.numObjsOfType(CppObjType::kHashInclude) >= 1);
+    CHECK(stats.numObjsOfType(CppObjType::kFunction) >= 1);
+    CHECK(stats.numObjsOfType(CppObjType::kCompound) >= 2);
+    CHECK(stats.lexSeconds >= 0);
+    CHECK(stats.parseSeconds >= 0);
+
+    REQUIRE(parser.parseFile(testFilePath) != nullptr);
+    CHECK(parser.stats().numParses == 2);
+    CHECK(parser.stats().numTokens == 2 * stats.numTokens);
+
+    parser.resetStats();
+    CHECK(parser.stats().numParses == 0);
+  }
+}
@@ -0,0 +1,143 @@
+#include <catch/catch.hpp>
+
+#include "cppast.h"
+#include "cppparser.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+// Patterns are global to all parsers, so the test clears them at its end for other tests to be unaffected.
+const char* const kInput = "namespace skipped_detail {\n"
+                           "  struct Inner { int x; };\n"
+                           "  void f() { if (true) { } }\n"
+                           "  const char* s = \"}\";\n"
+                           "  // }\n"
+                           "  /* } */\n"
+                           "}\n"
+                           "namespace kept_ns {\n"
+                           "  class WidgetSkippedImpl : public Base<int> {\n"
+                           "    int y;\n"
+                           "  };\n"
+                           "  class Widget {\n"
+                           "    int z;\n"
+                           "  };\n"
+                           "}\n"
+                           "enum class EnumSkippedImpl { kA, kB };\n"
+                           "int after;\n";
+
+CppCompoundPtr parse(CppParser& parser, const char* text = kInput)
+{
+  std::string       input(text);
+  std::vector<char> stm(input.begin(), input.end());
+  stm.push_back('\0');
+  stm.push_back('\0');
+  return parser.parseStream(stm.data(), stm.size());
+}
+
+const CppCompound* findCompound(const CppCompound* parent, const std::string& name)
+{
+  for (const auto& mem : parent->members())
+  {
+    if (mem->objType_ != CppObjType::kCompound)
+      continue;
+    auto* compound = static_cast<const CppCompound*>(mem.get());
+    if (compound->name() == name)
+      return compound;
+  }
+  return nullptr;
+}
+
+bool hasOnlyPlaceholder(const CppCompound* compound)
+{
+  return (compound->members().size() == 1) && (compound->members().front()->objType_ == CppObjType::kBlob);
+}
+
+// Clears patterns even when a REQUIRE fails.
+struct SkippedPatternsReset
+{
+  CppParser& parser;
+  ~SkippedPatternsReset()
+  {
+    parser.clearSkippedNamespaces();
+    parser.clearSkippedClasses();
+  }
+};
+
+} // namespace
+
+TEST_CASE("Skipping of bodies of namespaces and classes")
+{
+  CppParser            parser;
+  SkippedPatternsReset reset{parser};
+  parser.addSkippedNamespace("skipped_detail");
+  parser.addSkippedClass("*SkippedImpl");
+
+  auto cppAst = parse(parser);
+  REQUIRE(cppAst != nullptr);
+
+  auto* skippedNs = findCompound(cppAst.get(), "skipped_detail");
+  REQUIRE(skippedNs != nullptr);
+  CHECK(hasOnlyPlaceholder(skippedNs));
+
+  auto* keptNs = findCompound(cppAst.get(), "kept_ns");
+  REQUIRE(keptNs != nullptr);
+  REQUIRE(keptNs->members().size() == 2);
+
+  auto* skippedClass = findCompound(keptNs, "WidgetSkippedImpl");
+  REQUIRE(skippedClass != nullptr);
+  CHECK(hasOnlyPlaceholder(skippedClass));
+
+  auto* keptClass = findCompound(keptNs, "Widget");
+  REQUIRE(keptClass != nullptr);
+  REQUIRE(keptClass->members().size() == 1);
+  CHECK(keptClass->members().front()->objType_ == CppObjType::kVar);
+
+  // Enum is parsed as usual even though its name matches pattern of skipped classes.
+  CHECK(cppAst->members().size() == 4);
+
+  parser.clearSkippedNamespaces();
+  parser.clearSkippedClasses();
+  cppAst = parse(parser);
+  REQUIRE(cppAst != nullptr);
+  skippedNs = findCompound(cppAst.get(), "skipped_detail");
+  REQUIRE(skippedNs != nullptr);
+  CHECK(!hasOnlyPlaceholder(skippedNs));
+  CHECK(findCompound(skippedNs, "Inner") != nullptr);
+  keptNs = findCompound(cppAst.get(), "kept_ns");
+  REQUIRE(keptNs != nullptr);
+  skippedClass = findCompound(keptNs, "WidgetSkippedImpl");
+  REQUIRE(skippedClass != nullptr);
+  CHECK(!hasOnlyPlaceholder(skippedClass));
+}
+
+TEST_CASE("Braces of directives in skipped bodies")
+{
+  CppParser            parser;
+  SkippedPatternsReset reset{parser};
+  parser.addSkippedNamespace("skipped_detail");
+
+  // Only the first branch of a conditional directive is counted and braces of directives are not counted at all.
+  auto cppAst = parse(parser,
+                      "namespace skipped_detail {\n"
+                      "#define OPEN_BRACE {\n"
+                      "#define CLOSE_BRACE \\\n"
+                      "  }\n"
+                      "#if defined(HAS_BASE)\n"
+                      "  struct Cond : Base {\n"
+                      "#elif defined(HAS_OTHER_BASE)\n"
+                      "  struct Cond : OtherBase {\n"
+                      "#else\n"
+                      "  struct Cond {\n"
+                      "#endif\n"
+                      "  };\n"
+                      "}\n"
+                      "int after;\n");
+  REQUIRE(cppAst != nullptr);
+  REQUIRE(cppAst->members().size() == 2);
+  auto* skippedNs = findCompound(cppAst.get(), "skipped_detail");
+  REQUIRE(skippedNs != nullptr);
+  CHECK(hasOnlyPlaceholder(skippedNs));
+  CHECK(cppAst->members().back()->objType_ == CppObjType::kVar);
+}
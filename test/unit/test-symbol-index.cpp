@@ -0,0 +1,76 @@
+#include <catch/catch.hpp>
+
+#include "cppprog.h"
+#include "parse-snippet.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+CppCompoundPtr makeFileAst(const std::string& path = "file.h")
+{
+  return parseSnippet(path,
+                      "#define MAX_WIDGETS 16\n"
+                      "namespace gui {\n"
+                      "class Widget {\n"
+                      "public:\n"
+                      "  Widget();\n"
+                      "  void draw();\n"
+                      "private:\n"
+                      "  int width;\n"
+                      "};\n"
+                      "enum Color { kRed, kGreen };\n"
+                      "void drawAll();\n"
+                      "}\n");
+}
+
+} // namespace
+
+TEST_CASE("Symbol index of program")
+{
+  CppProgram program(std::vector<std::string>{});
+  program.addCppAst(makeFileAst());
+
+  const auto& index   = program.symbolIndex();
+  const auto* fileAst = program.getFileAsts().front().get();
+
+  auto widgetCtor = index.find("gui::Widget::Widget");
+  REQUIRE(widgetCtor.size() == 1);
+  CHECK(widgetCtor.front().obj->objType_ == CppObjType::kConstructor);
+  CHECK(widgetCtor.front().file == fileAst);
+
+  CHECK(index.find("::gui::Widget::draw").size() == 1);
+  CHECK(index.find("gui::Widget::width").size() == 1);
+  CHECK(index.find("gui::Color::kRed").size() == 1);
+  CHECK(index.find("gui::kGreen").size() == 1);
+  CHECK(index.find("MAX_WIDGETS").size() == 1);
+  CHECK(index.find("gui::Widget::paint").empty());
+
+  auto widgetMembers = index.findPrefix("gui::Widget::");
+  CHECK(widgetMembers.size() == 3);
+  CHECK(index.findPrefix("gui::draw").size() == 1);
+  CHECK(index.findPrefix("gui::").size() == 10);
+
+  SECTION("Index follows addition and removal of files")
+  {
+    const auto numSymbols = index.symbols().size();
+    program.addCppAst(makeFileAst("other.h"));
+    const auto* otherAst = program.getFileAsts().back().get();
+    CHECK(&program.symbolIndex() == &index);
+    CHECK(index.symbols().size() == 2 * numSymbols);
+    CHECK(std::is_sorted(index.symbols().begin(), index.symbols().end(), [](const CppSymbol& lhs, const CppSymbol& rhs) {
+      return lhs.name < rhs.name;
+    }));
+    auto draw = index.find("gui::Widget::draw");
+    REQUIRE(draw.size() == 2);
+    CHECK(draw.front().file == fileAst);
+    CHECK(draw.back().file == otherAst);
+
+    REQUIRE(program.removeFile("file.h"));
+    CHECK(index.symbols().size() == numSymbols);
+    draw = index.find("gui::Widget::draw");
+    REQUIRE(draw.size() == 1);
+    CHECK(draw.front().file == otherAst);
+  }
+}
@@ -0,0 +1,78 @@
+#include <catch/catch.hpp>
+
+#include "cpptracer.h"
+#include "cppwriter.h"
+
+#include <boost/filesystem.hpp>
+
+#include <sstream>
+#include <thread>
+
+TEST_CASE("Tracer records events per thread")
+{
+  CppTracer tracer(std::chrono::milliseconds(10));
+  {
+    CppTraceScope traceRead(&tracer, "read", "dir\\file \"1\".h");
+    traceRead.numBytes(42);
+  }
+  std::thread worker([&tracer]() {
+    CppTraceScope traceLoad(&tracer, "loadType", "file2.h");
+  });
+  worker.join();
+
+  const auto now = CppTracer::Clock::now();
+  tracer.recordIfSlow("trial", now - std::chrono::milliseconds(1), now);
+  tracer.recordIfSlow("lex", now - std::chrono::milliseconds(20), now);
+
+  const auto& events = tracer.events();
+  REQUIRE(events.size() == 6);
+  CHECK(events[0].phase == 'B');
+  CHECK(events[1].phase == 'E');
+  CHECK(events[1].numBytes == 42);
+  CHECK(events[0].tid == 0);
+  CHECK(events[2].tid == 1);
+  CHECK(events[3].tid == 1);
+  CHECK(std::string(events[4].name) == "lex");
+  CHECK(events[5].time - events[4].time == std::chrono::milliseconds(20));
+  REQUIRE(tracer.threadNames().size() == 2);
+
+  std::ostringstream json;
+  tracer.writeJson(json);
+  const auto str = json.str();
+  CHECK(str.find("{\"traceEvents\":[") == 0);
+  CHECK(str.find("\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"worker 1\"}") != str.npos);
+  CHECK(str.find("\"file\":\"dir\\\\file \\\"1\\\".h\"") != str.npos);
+  CHECK(str.find("\"bytes\":42") != str.npos);
+}
+
+TEST_CASE("Tracer records emission of files")
+{
+  const auto outputFolder = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+  std::vector<CppCompoundPtr> fileAsts;
+  std::vector<CppEmitJob>     jobs;
+  for (int i = 0; i < 4; ++i)
+  {
+    fileAsts.emplace_back(new CppCompound("file" + std::to_string(i) + ".h", CppCompoundType::kCppFile));
+    fileAsts.back()->addMember(new CppCompound("Class" + std::to_string(i), CppCompoundType::kClass));
+    jobs.emplace_back(fileAsts.back().get(), (outputFolder / ("file" + std::to_string(i) + ".h")).string());
+  }
+
+  CppTracer tracer;
+  CppWriter writer;
+  CHECK(writer.emitFiles(jobs, 2, &tracer).empty());
+
+  size_t numEmitted = 0;
+  for (const auto& event : tracer.events())
+  {
+    CHECK(std::string(event.name) == "emit");
+    if (event.phase == 'E')
+    {
+      ++numEmitted;
+      CHECK(event.numBytes == std::string("class ClassN\n{\n};\n").size());
+    }
+  }
+  CHECK(numEmitted == jobs.size());
+
+  boost::filesystem::remove_all(outputFolder);
+}
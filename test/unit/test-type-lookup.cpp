@@ -0,0 +1,235 @@
+#include <catch/catch.hpp>
+
+#include "cppprog.h"
+#include "parse-snippet.h"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+CppCompoundPtr makeFileAst()
+{
+  return parseSnippet("file.h",
+                      "namespace Outer {\n"
+                      "namespace Inner { class Widget {}; }\n"
+                      "class Gadget {};\n"
+                      "}\n");
+}
+
+// Files share namespaces so that merging of type-trees is exercised.
+CppCompoundPtr makeFileAst(int fileIdx)
+{
+  const auto idx = std::to_string(fileIdx);
+  return parseSnippet("file" + idx + ".h",
+                      "namespace Outer { namespace Inner" + std::to_string(fileIdx % 3) + " {\n"
+                        + "class Class" + idx + " { struct Nested {}; };\n"
+                        + "} }\n");
+}
+
+void compareTypeTrees(const CppTypeTreeNode& lhs, const CppTypeTreeNode& rhs)
+{
+  REQUIRE(lhs.children.size() == rhs.children.size());
+  CHECK(lhs.cppObjSet.size() == rhs.cppObjSet.size());
+  for (const auto& child : lhs.children)
+  {
+    auto itr = rhs.children.find(child.first);
+    REQUIRE(itr != rhs.children.end());
+    CHECK(child.second.parent == &lhs);
+    CHECK(itr->second.parent == &rhs);
+    compareTypeTrees(child.second, itr->second);
+  }
+}
+
+} // namespace
+
+TEST_CASE("Type lookup in program")
+{
+  CppProgram program(std::vector<std::string>{});
+  program.addCppAst(makeFileAst());
+
+  const auto* root  = program.findTypeNode("", nullptr);
+  const auto* inner = program.findTypeNode("Outer::Inner", root);
+  REQUIRE(inner != nullptr);
+
+  CHECK(program.findTypeNode("Widget", inner) != nullptr);
+  CHECK(program.findTypeNode("Gadget", inner) == program.findTypeNode("Outer::Gadget", root));
+  CHECK(program.findTypeNode("::Outer::Inner::Widget", inner) == program.findTypeNode("Widget", inner));
+  CHECK(program.findTypeNode("Widget", root) == nullptr);
+  CHECK(program.findTypeNode("Outer::Missing", root) == nullptr);
+
+  SECTION("Cached failure is invalidated when tree changes")
+  {
+    CHECK(program.findTypeNode("Gizmo", inner) == nullptr);
+
+    auto* outer = static_cast<const CppCompound*>(*program.findTypeNode("Outer", root)->cppObjSet.begin());
+    CppCompoundPtr gizmo(new CppCompound("Gizmo", CppAccessType::kPublic, CppCompoundType::kClass));
+    program.addCompound(gizmo.get(), outer);
+
+    CHECK(program.findTypeNode("Gizmo", inner) == program.findTypeNode("Outer::Gizmo", root));
+    CHECK(program.findTypeNode("Gizmo", inner) != nullptr);
+  }
+
+  SECTION("Concurrent lookup")
+  {
+    const auto*              widget = program.findTypeNode("Outer::Inner::Widget", root);
+    std::vector<std::thread> threads;
+    std::vector<int>         numMismatches(4, 0);
+    for (size_t t = 0; t < numMismatches.size(); ++t)
+    {
+      threads.emplace_back([&, t]() {
+        for (int i = 0; i < 1000; ++i)
+        {
+          if (program.findTypeNode("Widget", inner) != widget)
+            ++numMismatches[t];
+          if (program.findTypeNode("NoSuchType", inner) != nullptr)
+            ++numMismatches[t];
+        }
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+    for (auto numMismatch : numMismatches)
+      CHECK(numMismatch == 0);
+  }
+}
+
+TEST_CASE("Parallel loading of type-tree")
+{
+  const int        kNumFiles = 32;
+  CppCompoundArray serialAsts, parallelAsts;
+  for (int i = 0; i < kNumFiles; ++i)
+  {
+    serialAsts.push_back(makeFileAst(i));
+    parallelAsts.push_back(makeFileAst(i));
+  }
+
+  CppProgram serialProgram(std::vector<std::string>{});
+  for (auto& cppAst : serialAsts)
+    serialProgram.addCppAst(std::move(cppAst));
+
+  CppProgram parallelProgram(std::vector<std::string>{});
+  parallelProgram.addCppAsts(std::move(parallelAsts), 4);
+
+  const auto* serialRoot   = serialProgram.findTypeNode("", nullptr);
+  const auto* parallelRoot = parallelProgram.findTypeNode("", nullptr);
+  compareTypeTrees(*serialRoot, *parallelRoot);
+
+  REQUIRE(parallelProgram.getFileAsts().size() == kNumFiles);
+  for (int i = 0; i < kNumFiles; ++i)
+  {
+    const auto  name = "Outer::Inner" + std::to_string(i % 3) + "::Class" + std::to_string(i) + "::Nested";
+    const auto* node = parallelProgram.findTypeNode(name, parallelRoot);
+    REQUIRE(node != nullptr);
+    REQUIRE(node->cppObjSet.size() == 1);
+    CHECK(parallelProgram.typeTreeNodeFromCppObj(*node->cppObjSet.begin()) == node);
+    CHECK(parallelProgram.typeTreeNodeFromCppObj(parallelProgram.getFileAsts()[i].get()) == parallelRoot);
+  }
+}
+
+TEST_CASE("Removal of file from program")
+{
+  const int        kNumFiles = 12;
+  CppCompoundArray allAsts, keptAsts;
+  for (int i = 0; i < kNumFiles; ++i)
+  {
+    allAsts.push_back(makeFileAst(i));
+    if (i % 4 != 0)
+      keptAsts.push_back(makeFileAst(i));
+  }
+
+  CppProgram program(std::vector<std::string>{});
+  program.addCppAsts(std::move(allAsts), 1);
+  const auto* root = program.findTypeNode("", nullptr);
+  REQUIRE(program.findTypeNode("Outer::Inner0::Class0::Nested", root) != nullptr);
+
+  for (int i = 0; i < kNumFiles; i += 4)
+    CHECK(program.removeFile("file" + std::to_string(i) + ".h"));
+  CHECK(!program.removeFile("file0.h"));
+
+  CppProgram expectedProgram(std::vector<std::string>{});
+  expectedProgram.addCppAsts(std::move(keptAsts), 1);
+  compareTypeTrees(*expectedProgram.findTypeNode("", nullptr), *root);
+
+  CHECK(program.getFileAsts().size() == expectedProgram.getFileAsts().size());
+  CHECK(program.findTypeNode("Outer::Inner0::Class0", root) == nullptr);
+  // Outer was first added by removed file0.h and so its place must have been taken by namespace of another file.
+  const auto* outer = program.findTypeNode("Outer", root);
+  REQUIRE(outer != nullptr);
+  REQUIRE(outer->cppObjSet.size() == 1);
+  CHECK(program.typeTreeNodeFromCppObj(*outer->cppObjSet.begin()) == outer);
+  for (const auto& fileAst : program.getFileAsts())
+    CHECK(program.typeTreeNodeFromCppObj(fileAst.get()) == root);
+}
+
+namespace {
+
+void writeFile(const boost::filesystem::path& file, const std::string& content)
+{
+  std::ofstream stm(file.string(), std::ios::binary);
+  stm << content;
+}
+
+// Moves modification time forward so that change is noticed regardless of resolution of file times.
+void touchFile(const boost::filesystem::path& file)
+{
+  boost::filesystem::last_write_time(file, boost::filesystem::last_write_time(file) + 10);
+}
+
+} // namespace
+
+TEST_CASE("Refresh of changed files of program")
+{
+  namespace fs    = boost::filesystem;
+  const auto file = fs::temp_directory_path() / fs::unique_path("cppparser-refresh-%%%%-%%%%.h");
+  writeFile(file, "namespace Refreshed { class Before {}; }\n");
+
+  CppProgram  program(std::vector<std::string>{file.string()});
+  const auto* root = program.findTypeNode("", nullptr);
+  REQUIRE(program.getFileAsts().size() == 1);
+  REQUIRE(program.findTypeNode("Refreshed::Before", root) != nullptr);
+
+  SECTION("Content changed")
+  {
+    writeFile(file, "namespace Refreshed { class After {}; }\n");
+    touchFile(file);
+    CHECK(program.refresh() == 1);
+    CHECK(program.getFileAsts().size() == 1);
+    CHECK(program.findTypeNode("Refreshed::Before", root) == nullptr);
+    CHECK(program.findTypeNode("Refreshed::After", root) != nullptr);
+
+    writeFile(file, "namespace Refreshed { class Again {}; }\n");
+    CHECK(program.updateFile(file.string()));
+    CHECK(program.findTypeNode("Refreshed::After", root) == nullptr);
+    CHECK(program.findTypeNode("Refreshed::Again", root) != nullptr);
+  }
+
+  SECTION("Touched without change of content")
+  {
+    const auto* fileAst = program.getFileAsts().front().get();
+    const auto* before  = program.findTypeNode("Refreshed::Before", root);
+    touchFile(file);
+    CHECK(program.refresh() == 0);
+    CHECK(!program.updateFile(file.string()));
+    // Same AST means file was not parsed again.
+    REQUIRE(program.getFileAsts().size() == 1);
+    CHECK(program.getFileAsts().front().get() == fileAst);
+    CHECK(program.findTypeNode("Refreshed::Before", root) == before);
+  }
+
+  SECTION("Deleted")
+  {
+    fs::remove(file);
+    CHECK(program.refresh() == 1);
+    CHECK(program.getFileAsts().empty());
+    CHECK(program.findTypeNode("Refreshed", root) == nullptr);
+    CHECK(root->children.empty());
+    CHECK(program.refresh() == 0);
+  }
+
+  boost::system::error_code ec;
+  fs::remove(file, ec);
+}